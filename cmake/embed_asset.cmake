@@ -0,0 +1,16 @@
+# Writes the INPUT file into OUTPUT as a C array named NAME, followed by a zero so text assets
+# can be used as strings, and its size in NAME_size. Run at build time with cmake -P.
+
+file(READ "${INPUT}" content HEX)
+string(LENGTH "${content}" hexLength)
+math(EXPR size "${hexLength} / 2")
+
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${content}")
+string(REPEAT "0x[0-9a-f][0-9a-f]," 16 line)
+string(REGEX REPLACE "(${line})" "\\1\n    " bytes "${bytes}")
+
+get_filename_component(inputName "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+     "// Generated from ${inputName}, do not edit\n\n"
+     "const unsigned char ${NAME}[] = {\n    ${bytes}0x00};\n"
+     "const unsigned int ${NAME}_size = ${size};\n")
@@ -0,0 +1,18 @@
+#version 330
+// Samples the render target on a coarser grid of pixelWidth x pixelHeight blocks
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+out vec4 finalColor;
+const float renderWidth = 500;
+const float renderHeight = 375;
+uniform float pixelWidth = 8.0;
+uniform float pixelHeight = 8.0;
+void main() {
+    float dx = pixelWidth * (1.0 / renderWidth);
+    float dy = pixelHeight * (1.0 / renderHeight);
+    vec2 coord = vec2(dx * floor(fragTexCoord.x / dx), dy * floor(fragTexCoord.y / dy));
+    vec3 tc = texture(texture0, coord).rgb;
+    finalColor = vec4(tc, 1.0);
+}
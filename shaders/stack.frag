@@ -0,0 +1,16 @@
+#version 330
+// Alpha testing keeps only the opaque pixels so the depth test can reject covered ones
+in vec2 fragTexCoord;
+in vec4 fragColor;
+flat in float sliceLod;
+uniform sampler2D texture0;
+uniform int alphaTest;
+out vec4 finalColor;
+void main() {
+    vec4 texel = textureLod(texture0, fragTexCoord, sliceLod);
+    if (alphaTest != 0) {
+        if (texel.a < 0.5) discard;
+        texel.a = 1.0;
+    }
+    finalColor = texel * fragColor;
+}
@@ -0,0 +1,37 @@
+#version 330
+// Places one instance of a unit quad per slice. Instances carry the trimmed rectangle of the
+// slice on the sheet and the origin of its cell, so any sheet layout draws the same way.
+// Everything about the view comes from uniforms and never touches the vertex data. Slices get
+// increasing depth going up, the 2D projection maps -1 to the far plane and 0 to the near one.
+// Zoomed out slices sample the mip level matching their size on screen, up to the deepest
+// level that doesn't mix neighbouring cells.
+layout(location = 0) in vec2 vertexPosition;
+layout(location = 1) in vec4 sliceTrim;
+layout(location = 2) in vec2 sliceCell;
+uniform mat4 mvp;
+uniform vec2 sheetSize;
+uniform vec2 cellSize;
+uniform int sliceCount;
+uniform int reversed;
+uniform vec2 center;
+uniform float rotation;
+uniform float zoom;
+uniform float spacing;
+uniform float maxLod;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+flat out float sliceLod;
+void main() {
+    int slice = reversed != 0 ? sliceCount - 1 - gl_InstanceID : gl_InstanceID;
+    vec2 texel = sliceTrim.xy + vertexPosition * sliceTrim.zw;
+    vec2 local = (texel - sliceCell - 0.5 * cellSize) * zoom;
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 position = center + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+    position.y += (0.5 * float(sliceCount) - float(slice)) * spacing * zoom;
+    float depth = -1.0 + float(slice + 1) / float(sliceCount + 1);
+    fragTexCoord = texel / sheetSize;
+    fragColor = vec4(1.0);
+    sliceLod = clamp(-log2(zoom), 0.0, maxLod);
+    gl_Position = mvp * vec4(position, depth, 1.0);
+}
@@ -0,0 +1,276 @@
+#include "aseprite.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "byte_reader.h"
+#include "inflate.h"
+
+const uint16_t HEADER_MAGIC = 0xA5E0;
+const uint16_t FRAME_MAGIC = 0xF1FA;
+const size_t HEADER_SIZE = 128;
+// Same limit as the rows of .vox sheets, for both the sheet and every cel
+const int64_t MAX_SHEET_SIZE = 4096;
+
+const uint16_t CHUNK_OLD_PALETTE = 0x0004;
+const uint16_t CHUNK_LAYER = 0x2004;
+const uint16_t CHUNK_CEL = 0x2005;
+const uint16_t CHUNK_PALETTE = 0x2019;
+
+const uint16_t LAYER_VISIBLE = 1;
+const uint16_t LAYER_TYPE_IMAGE = 0;
+const uint32_t HEADER_LAYER_OPACITY_VALID = 1;
+
+const uint16_t CEL_RAW = 0;
+const uint16_t CEL_LINKED = 1;
+const uint16_t CEL_COMPRESSED = 2;
+
+struct AseLayer {
+    // Slice the layer becomes, -1 for groups, hidden and tilemap layers
+    int slice{-1};
+    uint8_t opacity{255};
+};
+
+struct AseCel {
+    int slice;
+    int frame;
+    int x;
+    int y;
+    int width;
+    int height;
+    // Cel opacity times layer opacity
+    uint32_t opacity;
+    const unsigned char *pixels;
+    size_t size;
+    bool compressed;
+};
+
+struct AseFile {
+    int width{0};
+    int height{0};
+    int depth{0};
+    int frames{0};
+    uint8_t transparentIndex{0};
+    float frameDuration{0.0f};
+    std::vector<AseLayer> layers;
+    std::vector<AseCel> cels;
+    std::vector<uint32_t> palette;
+    int slices{0};
+};
+
+static void ReadLayerChunk(Reader &reader, AseFile &file, bool opacityValid) {
+    uint16_t flags = ReadWord(reader);
+    uint16_t type = ReadWord(reader);
+    Skip(reader, 2 + 4 + 2); // Child level, default size, blend mode
+    uint8_t opacity = ReadByte(reader);
+
+    AseLayer layer;
+    layer.opacity = opacityValid ? opacity : 255;
+    if ((flags & LAYER_VISIBLE) != 0 && type == LAYER_TYPE_IMAGE) layer.slice = file.slices++;
+    file.layers.push_back(layer);
+}
+
+static void ReadCelChunk(Reader &reader, AseFile &file, int frame, size_t chunkEnd) {
+    uint16_t layerIndex = ReadWord(reader);
+    int16_t x = ReadShort(reader);
+    int16_t y = ReadShort(reader);
+    uint8_t opacity = ReadByte(reader);
+    uint16_t type = ReadWord(reader);
+    Skip(reader, 2 + 5); // Z-index, reserved
+    if (layerIndex >= file.layers.size() || file.layers[layerIndex].slice < 0) return;
+
+    const AseLayer &layer = file.layers[layerIndex];
+    if (type == CEL_LINKED) {
+        // Same image as the cel of the layer in an earlier frame
+        int linkedFrame = ReadWord(reader);
+        for (size_t i = 0; i < file.cels.size(); i++) {
+            if (file.cels[i].slice == layer.slice && file.cels[i].frame == linkedFrame) {
+                AseCel cel = file.cels[i];
+                cel.frame = frame;
+                file.cels.push_back(cel);
+                break;
+            }
+        }
+        return;
+    }
+    if (type != CEL_RAW && type != CEL_COMPRESSED) return;
+
+    AseCel cel;
+    cel.slice = layer.slice;
+    cel.frame = frame;
+    cel.x = x;
+    cel.y = y;
+    cel.width = ReadWord(reader);
+    cel.height = ReadWord(reader);
+    if (cel.width > MAX_SHEET_SIZE || cel.height > MAX_SHEET_SIZE) return;
+    cel.opacity = (uint32_t)opacity * layer.opacity / 255;
+    cel.pixels = reader.data + reader.pos;
+    cel.size = chunkEnd > reader.pos ? chunkEnd - reader.pos : 0;
+    cel.compressed = type == CEL_COMPRESSED;
+    if (reader.ok) file.cels.push_back(cel);
+}
+
+static void ReadPaletteChunk(Reader &reader, AseFile &file) {
+    uint32_t size = ReadDword(reader);
+    uint32_t first = ReadDword(reader);
+    uint32_t last = ReadDword(reader);
+    Skip(reader, 8);
+    if (size > 65536 || last >= size) return;
+
+    if (file.palette.size() < size) file.palette.resize(size, 0);
+    for (uint32_t i = first; i <= last && reader.ok; i++) {
+        uint16_t flags = ReadWord(reader);
+        uint32_t r = ReadByte(reader), g = ReadByte(reader), b = ReadByte(reader), a = ReadByte(reader);
+        file.palette[i] = r | (g << 8) | (b << 16) | (a << 24);
+        if (flags & 1) Skip(reader, ReadWord(reader)); // Color name
+    }
+}
+
+// Only used by files without the newer palette chunk
+static void ReadOldPaletteChunk(Reader &reader, AseFile &file) {
+    uint16_t packets = ReadWord(reader);
+    size_t index = 0;
+    for (uint16_t p = 0; p < packets && reader.ok; p++) {
+        index += ReadByte(reader);
+        int count = ReadByte(reader);
+        if (count == 0) count = 256;
+        for (int i = 0; i < count && reader.ok; i++, index++) {
+            uint32_t r = ReadByte(reader), g = ReadByte(reader), b = ReadByte(reader);
+            if (index < file.palette.size()) file.palette[index] = r | (g << 8) | (b << 16) | 0xFF000000u;
+        }
+    }
+}
+
+static bool ReadAseFile(Reader &reader, AseFile &file) {
+    ReadDword(reader); // File size
+    if (ReadWord(reader) != HEADER_MAGIC) return false;
+    file.frames = ReadWord(reader);
+    file.width = ReadWord(reader);
+    file.height = ReadWord(reader);
+    file.depth = ReadWord(reader);
+    uint32_t flags = ReadDword(reader);
+    Skip(reader, 2 + 4 + 4); // Speed, reserved
+    file.transparentIndex = ReadByte(reader);
+    reader.pos = HEADER_SIZE;
+    if (!reader.ok || reader.pos > reader.size) return false;
+    if (file.depth != 32 && file.depth != 16 && file.depth != 8) return false;
+    if (file.width == 0 || file.height == 0) return false;
+
+    file.palette.assign(256, 0);
+    bool newPalette = false;
+
+    for (int frame = 0; frame < file.frames; frame++) {
+        size_t frameStart = reader.pos;
+        uint32_t frameSize = ReadDword(reader);
+        uint16_t magic = ReadWord(reader);
+        uint16_t oldChunks = ReadWord(reader);
+        uint16_t duration = ReadWord(reader);
+        Skip(reader, 2);
+        uint32_t chunks = ReadDword(reader);
+        if (chunks == 0) chunks = oldChunks;
+
+        size_t frameEnd = frameStart + frameSize;
+        if (!reader.ok || magic != FRAME_MAGIC || frameEnd > reader.size) return false;
+        if (frame == 0) file.frameDuration = duration / 1000.0f;
+
+        for (uint32_t c = 0; c < chunks; c++) {
+            size_t chunkStart = reader.pos;
+            uint32_t chunkSize = ReadDword(reader);
+            uint16_t type = ReadWord(reader);
+            size_t chunkEnd = chunkStart + chunkSize;
+            if (!reader.ok || chunkSize < 6 || chunkEnd > frameEnd) return false;
+
+            if (type == CHUNK_LAYER) {
+                ReadLayerChunk(reader, file, (flags & HEADER_LAYER_OPACITY_VALID) != 0);
+            } else if (type == CHUNK_CEL) {
+                ReadCelChunk(reader, file, frame, chunkEnd);
+            } else if (type == CHUNK_PALETTE) {
+                ReadPaletteChunk(reader, file);
+                newPalette = true;
+            } else if (type == CHUNK_OLD_PALETTE && !newPalette) {
+                ReadOldPaletteChunk(reader, file);
+            }
+
+            // Chunks are skipped by their size, whatever was read of them
+            reader.ok = true;
+            reader.pos = chunkEnd;
+        }
+        reader.pos = frameEnd;
+    }
+    // Checked once the layers are known, in 64 bits as both factors come from the file
+    bool fits = (int64_t)file.width * file.slices <= MAX_SHEET_SIZE &&
+                (int64_t)file.height * file.frames <= MAX_SHEET_SIZE;
+    return file.slices > 0 && file.frames > 0 && fits;
+}
+
+static uint32_t ConvertPixel(const AseFile &file, const unsigned char *pixel) {
+    switch (file.depth) {
+    case 32:
+        return pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) | ((uint32_t)pixel[3] << 24);
+    case 16:
+        return pixel[0] | (pixel[0] << 8) | (pixel[0] << 16) | ((uint32_t)pixel[1] << 24);
+    default:
+        return pixel[0] == file.transparentIndex ? 0 : file.palette[pixel[0]];
+    }
+}
+
+// Writes the cel into the cell of its (slice, frame), cells never overlap so cels can be
+// placed concurrently
+static void PlaceCel(const AseFile &file, const AseCel &cel, Image &sheet) {
+    int bytesPerPixel = file.depth / 8;
+    size_t expected = (size_t)cel.width * cel.height * bytesPerPixel;
+
+    const unsigned char *pixels = cel.pixels;
+    std::vector<unsigned char> inflated;
+    if (cel.compressed) {
+        // Raw DEFLATE after the two byte zlib header, the Adler-32 trailer is ignored
+        if (cel.size <= 2 || expected == 0) return;
+        // Inflated into a buffer of the cel's own size, raylib's DecompressData allocates 64 MB per call
+        inflated.resize(expected);
+        if (!InflateData(cel.pixels + 2, cel.size - 2, inflated.data(), expected)) return;
+        pixels = inflated.data();
+    } else if (cel.size < expected) {
+        return;
+    }
+
+    uint32_t *target = static_cast<uint32_t *>(sheet.data);
+    for (int y = 0; y < cel.height; y++) {
+        int canvasY = cel.y + y;
+        if (canvasY < 0 || canvasY >= file.height) continue;
+        uint32_t *row = target + (size_t)(cel.frame * file.height + canvasY) * sheet.width + cel.slice * file.width;
+
+        for (int x = 0; x < cel.width; x++) {
+            int canvasX = cel.x + x;
+            if (canvasX < 0 || canvasX >= file.width) continue;
+
+            uint32_t color = ConvertPixel(file, pixels + ((size_t)y * cel.width + x) * bytesPerPixel);
+            uint32_t alpha = (color >> 24) * cel.opacity / 255;
+            row[canvasX] = alpha == 0 ? 0 : (color & 0x00FFFFFFu) | (alpha << 24);
+        }
+    }
+}
+
+bool IsAsepriteFile(const char *path) { return IsFileExtension(path, ".ase;.aseprite"); }
+
+AsepriteSheet LoadAsepriteFromMemory(const unsigned char *data, int size, ThreadPool &pool) {
+    AsepriteSheet sheet;
+    if (data == nullptr || size <= 0) return sheet;
+
+    Reader reader{data, (size_t)size, 0, true};
+    AseFile file;
+    if (!ReadAseFile(reader, file)) return sheet;
+
+    sheet.image = GenImageColor(file.width * file.slices, file.height * file.frames, BLANK);
+    if (sheet.image.data == nullptr) return sheet;
+    sheet.slices = file.slices;
+    sheet.frames = file.frames;
+    sheet.frameDuration = file.frameDuration;
+
+    ParallelFor(pool, (int)file.cels.size(), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) PlaceCel(file, file.cels[i], sheet.image);
+    });
+
+    return sheet;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "raylib.h"
+#include "thread_pool.h"
+
+// An Aseprite file as a row-major RGBA8 sheet: every visible image layer is a slice, bottom
+// layer first, and every frame an animation step
+struct AsepriteSheet {
+    Image image{};
+    int slices{0};
+    int frames{0};
+    // Duration of the first frame in seconds
+    float frameDuration{0.0f};
+};
+
+bool IsAsepriteFile(const char *path);
+// Reads the chunks in file order, then decompresses and places the cels in parallel on the
+// pool. The image is left empty when the data is not a supported Aseprite file or the sheet
+// would be over 4096 texels wide or high.
+AsepriteSheet LoadAsepriteFromMemory(const unsigned char *data, int size, ThreadPool &pool);
@@ -0,0 +1,16 @@
+#pragma once
+
+// Files compiled into their own objects by CMake (cmake/embed_asset.cmake), each followed by
+// a zero. Rebuilding the sources never parses them again and they stay in read-only data.
+extern "C" {
+extern const unsigned char default_vert[];
+extern const unsigned char pixelizer_frag[];
+extern const unsigned char stack_vert[];
+extern const unsigned char stack_frag[];
+// Alpha of the UI font atlas, DEFLATE compressed by the font baker
+extern const unsigned char ui_font_atlas[];
+extern const unsigned int ui_font_atlas_size;
+}
+
+// Text assets, like shaders, are used as strings
+inline const char *GetAssetText(const unsigned char *asset) { return reinterpret_cast<const char *>(asset); }
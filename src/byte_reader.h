@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Little-endian cursor over a file in memory, reading past the end yields zeros and clears ok
+struct Reader {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    bool ok;
+};
+
+inline uint32_t ReadBytes(Reader &reader, int count) {
+    if (reader.pos + count > reader.size) {
+        reader.ok = false;
+        reader.pos = reader.size;
+        return 0;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++) value |= (uint32_t)reader.data[reader.pos + i] << (8 * i);
+    reader.pos += count;
+    return value;
+}
+
+inline uint8_t ReadByte(Reader &reader) { return (uint8_t)ReadBytes(reader, 1); }
+inline uint16_t ReadWord(Reader &reader) { return (uint16_t)ReadBytes(reader, 2); }
+inline int16_t ReadShort(Reader &reader) { return (int16_t)ReadBytes(reader, 2); }
+inline uint32_t ReadDword(Reader &reader) { return ReadBytes(reader, 4); }
+
+inline void Skip(Reader &reader, size_t count) {
+    if (reader.pos + count > reader.size) reader.ok = false;
+    reader.pos = std::min(reader.pos + count, reader.size);
+}
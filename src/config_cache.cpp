@@ -0,0 +1,173 @@
+#include "config_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "sheet_layout.h"
+
+const char CONFIG_CACHE_MAGIC[4] = {'M', 'S', 'C', 'C'};
+const uint32_t CONFIG_CACHE_VERSION = 3;
+// Same records without the content order, still read
+const uint32_t CONFIG_CACHE_VERSION_UNORDERED = 2;
+// More cells than pixels along a side of the largest sheets
+const int16_t MAX_CONFIG_FRAMES = 4096;
+
+struct ConfigCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+static bool RecordLess(const SheetConfigRecord &a, const SheetConfigRecord &b) {
+    return a.pathHash != b.pathHash ? a.pathHash < b.pathHash : a.contentHash < b.contentHash;
+}
+
+static uint64_t PendingKey(uint64_t pathHash, uint64_t contentHash) {
+    return pathHash ^ (contentHash * 0x9e3779b97f4a7c15ull);
+}
+
+static bool IsValidConfig(const SheetConfig &config) {
+    auto validFrames = [](int16_t frames) { return frames >= 1 && frames <= MAX_CONFIG_FRAMES; };
+    return validFrames(config.hFrames) && validFrames(config.vFrames) && std::isfinite(config.frameDuration) &&
+           config.frameDuration > 0.0f && config.layout <= (uint8_t)LayoutOrder::SliceGrid;
+}
+
+// A damaged order may point past the records, it then sorts last and is never matched
+static uint64_t GetOrderedContentHash(const ConfigCache &cache, uint32_t position) {
+    return position < cache.recordCount ? cache.records[position].contentHash : UINT64_MAX;
+}
+
+bool LoadConfigCache(ConfigCache &cache, const std::string &path) {
+    cache.path = path;
+    if (!MapFile(cache.index, path)) return false;
+
+    ConfigCacheHeader header;
+    if (cache.index.size < sizeof(header)) {
+        UnmapFile(cache.index);
+        return false;
+    }
+    std::memcpy(&header, cache.index.data, sizeof(header));
+
+    bool ordered = header.version == CONFIG_CACHE_VERSION;
+    size_t recordsSize = (size_t)header.count * sizeof(SheetConfigRecord);
+    size_t orderSize = ordered ? (size_t)header.count * sizeof(uint32_t) : 0;
+    bool valid = std::memcmp(header.magic, CONFIG_CACHE_MAGIC, 4) == 0 &&
+                 (ordered || header.version == CONFIG_CACHE_VERSION_UNORDERED) &&
+                 cache.index.size >= sizeof(header) + recordsSize + orderSize;
+    if (!valid) {
+        UnmapFile(cache.index);
+        return false;
+    }
+
+    cache.records = reinterpret_cast<const SheetConfigRecord *>(cache.index.data + sizeof(header));
+    if (ordered)
+        cache.contentOrder = reinterpret_cast<const uint32_t *>(cache.index.data + sizeof(header) + recordsSize);
+    cache.recordCount = header.count;
+    return true;
+}
+
+void UnloadConfigCache(ConfigCache &cache) {
+    UnmapFile(cache.index);
+    cache.records = nullptr;
+    cache.contentOrder = nullptr;
+    cache.recordCount = 0;
+    cache.pending.clear();
+}
+
+bool FindSheetConfig(const ConfigCache &cache, uint64_t pathHash, uint64_t contentHash, SheetConfig &config) {
+    auto pending = cache.pending.find(PendingKey(pathHash, contentHash));
+    if (pending != cache.pending.end()) {
+        config = pending->second.config;
+        return true;
+    }
+
+    const SheetConfigRecord *begin = cache.records;
+    const SheetConfigRecord *end = cache.records + cache.recordCount;
+    SheetConfigRecord key{pathHash, contentHash, {}};
+    auto found = [&](const SheetConfigRecord &record) {
+        if (!IsValidConfig(record.config)) return false;
+        config = record.config;
+        return true;
+    };
+
+    const SheetConfigRecord *exact = std::lower_bound(begin, end, key, RecordLess);
+    if (exact != end && exact->pathHash == pathHash && exact->contentHash == contentHash && found(*exact))
+        return true;
+
+    if (cache.contentOrder != nullptr) {
+        const uint32_t *orderEnd = cache.contentOrder + cache.recordCount;
+        const uint32_t *position = std::lower_bound(
+            cache.contentOrder, orderEnd, contentHash,
+            [&](uint32_t position, uint64_t hash) { return GetOrderedContentHash(cache, position) < hash; });
+        for (; position != orderEnd && GetOrderedContentHash(cache, *position) == contentHash; position++) {
+            if (found(cache.records[*position])) return true;
+        }
+    } else {
+        for (const SheetConfigRecord *record = begin; record != end; record++) {
+            if (record->contentHash == contentHash && found(*record)) return true;
+        }
+    }
+
+    // Records of the same path are adjacent, the exact lookup landed next to them
+    if (exact != end && exact->pathHash == pathHash && found(*exact)) return true;
+    if (exact != begin && (exact - 1)->pathHash == pathHash && found(*(exact - 1))) return true;
+
+    return false;
+}
+
+void StoreSheetConfig(ConfigCache &cache, uint64_t pathHash, uint64_t contentHash, const SheetConfig &config) {
+    cache.pending[PendingKey(pathHash, contentHash)] = SheetConfigRecord{pathHash, contentHash, config};
+}
+
+bool SaveConfigCache(ConfigCache &cache) {
+    if (cache.pending.empty()) return true;
+
+    std::vector<SheetConfigRecord> records;
+    records.reserve(cache.recordCount + cache.pending.size());
+    for (uint32_t i = 0; i < cache.recordCount; i++) {
+        const SheetConfigRecord &record = cache.records[i];
+        if (cache.pending.count(PendingKey(record.pathHash, record.contentHash)) == 0) records.push_back(record);
+    }
+    for (const auto &pending : cache.pending) records.push_back(pending.second);
+    std::sort(records.begin(), records.end(), RecordLess);
+
+    std::vector<uint32_t> contentOrder(records.size());
+    for (size_t i = 0; i < records.size(); i++) contentOrder[i] = (uint32_t)i;
+    std::sort(contentOrder.begin(), contentOrder.end(),
+              [&](uint32_t a, uint32_t b) { return records[a].contentHash < records[b].contentHash; });
+
+    ConfigCacheHeader header{};
+    std::memcpy(header.magic, CONFIG_CACHE_MAGIC, 4);
+    header.version = CONFIG_CACHE_VERSION;
+    header.count = (uint32_t)records.size();
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cache.path).parent_path(), error);
+
+    std::string tempPath = cache.path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(SheetConfigRecord));
+        file.write(reinterpret_cast<const char *>(contentOrder.data()), contentOrder.size() * sizeof(uint32_t));
+        if (!file) return false;
+    }
+
+    // The old index can't be replaced while it is mapped on Windows
+    UnmapFile(cache.index);
+    cache.records = nullptr;
+    cache.contentOrder = nullptr;
+    cache.recordCount = 0;
+
+    std::filesystem::rename(tempPath, cache.path, error);
+    if (!error) cache.pending.clear();
+
+    LoadConfigCache(cache, cache.path);
+    return !error;
+}
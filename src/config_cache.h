@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "mapped_file.h"
+
+// Settings restored when a sheet is opened again
+struct SheetConfig {
+    int16_t hFrames{1};
+    int16_t vFrames{1};
+    float frameDuration{1.0f};
+    uint8_t rotation{1};
+    uint8_t pixelizer{0};
+    uint8_t bkgColorId{0};
+    uint8_t depthTest{0};
+    // LayoutOrder of the slices
+    uint8_t layout{0};
+    uint8_t reserved[3]{};
+};
+
+// On-disk index record, sorted by pathHash then contentHash
+struct SheetConfigRecord {
+    uint64_t pathHash;
+    uint64_t contentHash;
+    SheetConfig config;
+};
+
+static_assert(sizeof(SheetConfigRecord) == 32, "The index layout is part of the file format");
+
+// Index of sheet configurations. The index file is memory-mapped at startup and never parsed,
+// configs stored during the session are kept aside and merged into it on save. The records are
+// followed by their positions sorted by content hash, so moved files are found without a scan.
+struct ConfigCache {
+    std::string path;
+    MappedFile index;
+    const SheetConfigRecord *records{nullptr};
+    // Null for files written before it was stored, content lookups scan the records until the next save
+    const uint32_t *contentOrder{nullptr};
+    uint32_t recordCount{0};
+    std::unordered_map<uint64_t, SheetConfigRecord> pending;
+};
+
+bool LoadConfigCache(ConfigCache &cache, const std::string &path);
+void UnloadConfigCache(ConfigCache &cache);
+// Looks for the exact sheet first, then for the same content under another path (moved
+// file), then for the same path with other content (edited file). Records with fields out of
+// range, from a damaged file, are passed over.
+bool FindSheetConfig(const ConfigCache &cache, uint64_t pathHash, uint64_t contentHash, SheetConfig &config);
+void StoreSheetConfig(ConfigCache &cache, uint64_t pathHash, uint64_t contentHash, const SheetConfig &config);
+bool SaveConfigCache(ConfigCache &cache);
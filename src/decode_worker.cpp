@@ -0,0 +1,274 @@
+#include "decode_worker.h"
+
+#include <algorithm>
+#include <functional>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "aseprite.h"
+#include "hash.h"
+#include "mipmaps.h"
+#include "sheet_layout.h"
+#include "texture_compress.h"
+#include "vox_model.h"
+
+// Same limit as the frame spinners of the configuration panel
+const int MAX_DETECTED_FRAMES = 100;
+
+// Read once to both hash and decode the file
+static Image DecodeImageFile(const std::string &path, uint64_t &contentHash) {
+    int dataSize = 0;
+    unsigned char *data = LoadFileData(path.c_str(), &dataSize);
+    if (data == nullptr) return Image{};
+
+    contentHash = HashBytes(data, dataSize, contentHash);
+    Image image = LoadImageFromMemory(GetFileExtension(path.c_str()), data, dataSize);
+    UnloadFileData(data);
+    return image;
+}
+
+static void FinishSheet(DecodedSheet &sheet) {
+    ImageFlipVertical(&sheet.image);
+    if (sheet.mipmaps) {
+        ImageFormat(&sheet.image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        GenImageBoxMipmaps(sheet.image);
+    }
+    sheet.alphaMask = BuildAlphaMask(sheet.image);
+}
+
+// The layers and frames give the grid, there is nothing to detect
+static void DecodeAsepriteFile(DecodedSheet &sheet, ThreadPool &pool) {
+    int dataSize = 0;
+    unsigned char *data = LoadFileData(sheet.path.c_str(), &dataSize);
+    if (data == nullptr) return;
+
+    sheet.contentHash = HashBytes(data, dataSize);
+    AsepriteSheet aseprite = LoadAsepriteFromMemory(data, dataSize, pool);
+    UnloadFileData(data);
+    if (aseprite.image.data == nullptr) return;
+
+    sheet.image = aseprite.image;
+    sheet.grid.hFrames = aseprite.slices;
+    sheet.grid.vFrames = aseprite.frames;
+    sheet.grid.found = true;
+    sheet.frameDuration = aseprite.frameDuration;
+    FinishSheet(sheet);
+}
+
+// Slices of the model, laid out by the loader
+static void DecodeVoxFile(DecodedSheet &sheet, ThreadPool &pool) {
+    int dataSize = 0;
+    unsigned char *data = LoadFileData(sheet.path.c_str(), &dataSize);
+    if (data == nullptr) return;
+
+    sheet.contentHash = HashBytes(data, dataSize);
+    VoxSheet vox = LoadVoxFromMemory(data, dataSize, pool);
+    UnloadFileData(data);
+    if (vox.image.data == nullptr) return;
+
+    sheet.image = vox.image;
+    sheet.grid.hFrames = GetLayoutColumns(vox.layout);
+    sheet.grid.vFrames = GetLayoutRows(vox.layout);
+    sheet.grid.found = true;
+    sheet.layout = vox.layout.order;
+    FinishSheet(sheet);
+}
+
+DecodedSheet DecodeSheet(const std::string &path, bool reload, bool mipmaps, ThreadPool &pool) {
+    DecodedSheet sheet;
+    sheet.path = path;
+    sheet.reload = reload;
+    sheet.mipmaps = mipmaps;
+    sheet.modTime = GetFileModTime(path.c_str());
+
+    if (IsAsepriteFile(path.c_str())) {
+        DecodeAsepriteFile(sheet, pool);
+        return sheet;
+    }
+    if (IsVoxFile(path.c_str())) {
+        DecodeVoxFile(sheet, pool);
+        return sheet;
+    }
+
+    sheet.contentHash = 0xcbf29ce484222325ull;
+    sheet.image = DecodeImageFile(path, sheet.contentHash);
+    if (sheet.image.data == nullptr) return sheet;
+
+    FinishSheet(sheet);
+    if (!reload) sheet.grid = DetectSheetGrid(sheet.image, MAX_DETECTED_FRAMES);
+
+    return sheet;
+}
+
+DecodedSheet DecodeSliceFiles(const std::vector<std::string> &paths, bool reload, bool mipmaps, ThreadPool &pool) {
+    DecodedSheet sheet;
+    sheet.path = paths.front();
+    sheet.slicePaths = paths;
+    sheet.reload = reload;
+    sheet.mipmaps = mipmaps;
+
+    std::vector<Image> slices(paths.size());
+    std::vector<uint64_t> hashes(paths.size(), 0xcbf29ce484222325ull);
+    ParallelFor(pool, (int)paths.size(), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            slices[i] = DecodeImageFile(paths[i], hashes[i]);
+            if (slices[i].data != nullptr) ImageFormat(&slices[i], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        }
+    });
+
+    // Any file changing changes the sheet
+    bool complete = true;
+    for (size_t i = 0; i < paths.size(); i++) {
+        sheet.modTime = std::max(sheet.modTime, GetFileModTime(paths[i].c_str()));
+        sheet.contentHash = HashBytes(&hashes[i], sizeof(hashes[i]), sheet.contentHash);
+        complete = complete && slices[i].data != nullptr;
+    }
+    if (complete) sheet.image = PackSliceImages(slices);
+    for (Image &slice : slices) UnloadImage(slice);
+    if (sheet.image.data == nullptr) return sheet;
+
+    FinishSheet(sheet);
+    if (!reload) {
+        // One column per file, the frames of each file are stacked vertically
+        sheet.grid = DetectSheetGrid(sheet.image, MAX_DETECTED_FRAMES);
+        sheet.grid.hFrames = (int)paths.size();
+        sheet.grid.found = true;
+    }
+
+    return sheet;
+}
+
+static void PruneCompressedSheets(DecodeWorker &worker) {
+    if (worker.textureCache.empty()) return;
+    uint64_t deleted = PruneTextureCache(worker.textureCache, worker.textureCacheBudget);
+    if (deleted > 0) TraceLog(LOG_INFO, "COMPRESS: Deleted %.1f MB of least recently used sheets", deleted / 1048576.0);
+}
+
+// Runs after the grid detection and alpha mask, which read the RGBA8 texels
+static void CompressSheet(DecodedSheet &sheet, DecodeWorker &worker) {
+    if (sheet.image.data == nullptr) return;
+
+    const char *name = GetFileName(sheet.path.c_str());
+    int width = sheet.image.width, height = sheet.image.height;
+    CompressionResult result = CompressImageDxt5(sheet.image, sheet.contentHash, worker.textureCache, worker.pool);
+    if (!result.compressed) {
+        TraceLog(LOG_INFO, "COMPRESS: [%s] %dx%d is not made of 4x4 blocks, kept as RGBA8", name, width, height);
+        return;
+    }
+    TraceLog(LOG_INFO, "COMPRESS: [%s] DXT5 %dx%d, %d levels, %.2f dB PSNR%s", name, width, height,
+             sheet.image.mipmaps, result.psnr, result.cached ? " (cached)" : "");
+    if (!result.cached) PruneCompressedSheets(worker);
+}
+
+static void RunDecodeWorker(DecodeWorker &worker) {
+    // The cache is only written from this thread
+    PruneCompressedSheets(worker);
+    std::unique_lock<std::mutex> lock(worker.mutex);
+
+    while (true) {
+        worker.wake.wait(lock, [&worker] { return !worker.running || !worker.requests.empty(); });
+        if (!worker.running) break;
+
+        DecodedSheet request = std::move(worker.requests.front());
+        worker.requests.pop_front();
+        worker.decoding = true;
+
+        lock.unlock();
+        DecodedSheet sheet = request.slicePaths.size() > 1
+                                 ? DecodeSliceFiles(request.slicePaths, request.reload, request.mipmaps, worker.pool)
+                                 : DecodeSheet(request.path, request.reload, request.mipmaps, worker.pool);
+        sheet.prefetch = request.prefetch;
+        sheet.compress = request.compress;
+        if (sheet.compress) CompressSheet(sheet, worker);
+        lock.lock();
+
+        worker.results.push_back(std::move(sheet));
+        worker.decoding = false;
+        worker.finished.notify_all();
+        // Unblocks the main loop if it is waiting for events
+        glfwPostEmptyEvent();
+    }
+}
+
+bool IsSheetFile(const std::string &path) {
+    const char *file = path.c_str();
+    return IsFileExtension(file, ".png;.bmp;.tga;.gif;.qoi") || IsAsepriteFile(file) || IsVoxFile(file);
+}
+
+void StartDecodeWorker(DecodeWorker &worker) {
+    worker.running = true;
+    StartThreadPool(worker.pool);
+    worker.thread = std::thread(RunDecodeWorker, std::ref(worker));
+}
+
+void StopDecodeWorker(DecodeWorker &worker) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.running = false;
+    }
+    worker.wake.notify_one();
+    if (worker.thread.joinable()) worker.thread.join();
+    StopThreadPool(worker.pool);
+
+    for (DecodedSheet &sheet : worker.results) UnloadImage(sheet.image);
+    worker.results.clear();
+    worker.requests.clear();
+}
+
+void RequestSheetDecode(DecodeWorker &worker, const std::vector<std::string> &paths, bool reload, bool mipmaps,
+                        bool compress) {
+    if (paths.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        DecodedSheet request;
+        request.path = paths.front();
+        if (paths.size() > 1) request.slicePaths = paths;
+        request.reload = reload;
+        request.mipmaps = mipmaps;
+        request.compress = compress;
+        worker.requests.push_back(std::move(request));
+    }
+    worker.wake.notify_one();
+}
+
+void RequestSheetPrefetch(DecodeWorker &worker, const std::string &path, bool mipmaps, bool compress) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        DecodedSheet request;
+        request.path = path;
+        request.mipmaps = mipmaps;
+        request.compress = compress;
+        request.prefetch = true;
+        worker.requests.push_back(std::move(request));
+    }
+    worker.wake.notify_one();
+}
+
+void CancelSheetPrefetches(DecodeWorker &worker) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    auto prefetch = [](const DecodedSheet &request) { return request.prefetch; };
+    worker.requests.erase(std::remove_if(worker.requests.begin(), worker.requests.end(), prefetch),
+                          worker.requests.end());
+    worker.finished.notify_all();
+}
+
+bool PollDecodedSheet(DecodeWorker &worker, DecodedSheet &sheet) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.results.empty()) return false;
+
+    sheet = std::move(worker.results.front());
+    worker.results.pop_front();
+    return true;
+}
+
+bool WaitDecodedSheet(DecodeWorker &worker, DecodedSheet &sheet) {
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.finished.wait(lock, [&worker] {
+        return !worker.results.empty() || (worker.requests.empty() && !worker.decoding) || !worker.running;
+    });
+    if (worker.results.empty()) return false;
+
+    sheet = std::move(worker.results.front());
+    worker.results.pop_front();
+    return true;
+}
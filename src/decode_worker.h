@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "grid_detect.h"
+#include "raylib.h"
+#include "sheet_layout.h"
+#include "slice_trim.h"
+#include "thread_pool.h"
+
+// A sheet read, hashed and decoded off the main thread, ready for the texture upload. Sheets
+// made of one file per slice keep every file and are known by the first one.
+struct DecodedSheet {
+    std::string path;
+    std::vector<std::string> slicePaths;
+    long modTime{0};
+    uint64_t contentHash{0};
+    Image image{};
+    GridGuess grid;
+    // Order of the grid when the file gives it
+    LayoutOrder layout{LayoutOrder::RowMajor};
+    // From the file when it stores one, zero otherwise
+    float frameDuration{0.0f};
+    AlphaMask alphaMask;
+    bool reload{false};
+    bool mipmaps{false};
+    // Block compressed on the worker, the image stays RGBA8 when it can't be
+    bool compress{false};
+    // Decoded ahead of being shown
+    bool prefetch{false};
+};
+
+struct DecodeWorker {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::deque<DecodedSheet> requests;
+    std::deque<DecodedSheet> results;
+    // Decodes the files of a sheet made of slice files in parallel
+    ThreadPool pool;
+    // Where compressed sheets are kept and how much disk they may take, set before starting. The
+    // least recently used are deleted at start and whenever a new one is written.
+    std::string textureCache;
+    uint64_t textureCacheBudget{1ull << 30};
+    bool running{false};
+    bool decoding{false};
+};
+
+// Decodes a sheet on the calling thread, the grid is only detected for new sheets. With
+// mipmaps the image is converted to RGBA8 and carries its mip chain. Aseprite files are read
+// directly with their layers as slices and MagicaVoxel models sliced along z, the pool
+// decompresses the cels or colours the voxels.
+DecodedSheet DecodeSheet(const std::string &path, bool reload, bool mipmaps, ThreadPool &pool);
+// Decodes one file per slice and packs them into a row-major sheet with a column per file
+DecodedSheet DecodeSliceFiles(const std::vector<std::string> &paths, bool reload, bool mipmaps, ThreadPool &pool);
+
+// Images raylib reads, Aseprite files and MagicaVoxel models
+bool IsSheetFile(const std::string &path);
+
+void StartDecodeWorker(DecodeWorker &worker);
+void StopDecodeWorker(DecodeWorker &worker);
+// A single path is a sheet, more are the slice files of one sheet. Compressed sheets are DXT5,
+// with their mip chain cut to whole blocks.
+void RequestSheetDecode(DecodeWorker &worker, const std::vector<std::string> &paths, bool reload, bool mipmaps,
+                        bool compress);
+// Decodes a sheet that is likely to be opened next, it comes back flagged as a prefetch
+void RequestSheetPrefetch(DecodeWorker &worker, const std::string &path, bool mipmaps, bool compress);
+// Drops the prefetches not started yet
+void CancelSheetPrefetches(DecodeWorker &worker);
+// Hands over the next finished sheet, the caller owns its image
+bool PollDecodedSheet(DecodeWorker &worker, DecodedSheet &sheet);
+// Same as polling, but blocks until the next sheet is finished. False when nothing is pending.
+bool WaitDecodedSheet(DecodeWorker &worker, DecodedSheet &sheet);
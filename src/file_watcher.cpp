@@ -0,0 +1,57 @@
+#include "file_watcher.h"
+
+#include <chrono>
+#include <functional>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "raylib.h"
+
+const auto POLL_INTERVAL = std::chrono::milliseconds(100);
+
+static void RunFileWatcher(FileWatcher &watcher) {
+    std::unique_lock<std::mutex> lock(watcher.mutex);
+
+    while (watcher.running) {
+        watcher.wake.wait_for(lock, POLL_INTERVAL);
+        if (!watcher.running) continue;
+
+        bool changed = false;
+        for (size_t i = 0; i < watcher.paths.size(); i++) {
+            long modTime = GetFileModTime(watcher.paths[i].c_str());
+            if (modTime != watcher.modTimes[i]) {
+                watcher.modTimes[i] = modTime;
+                changed = true;
+            }
+        }
+        if (changed) {
+            watcher.changed = true;
+            // Unblocks the main loop if it is waiting for events
+            glfwPostEmptyEvent();
+        }
+    }
+}
+
+void StartFileWatcher(FileWatcher &watcher) {
+    watcher.running = true;
+    watcher.thread = std::thread(RunFileWatcher, std::ref(watcher));
+}
+
+void StopFileWatcher(FileWatcher &watcher) {
+    {
+        std::lock_guard<std::mutex> lock(watcher.mutex);
+        watcher.running = false;
+    }
+    watcher.wake.notify_one();
+    if (watcher.thread.joinable()) watcher.thread.join();
+}
+
+void WatchFiles(FileWatcher &watcher, const std::vector<std::string> &paths) {
+    std::lock_guard<std::mutex> lock(watcher.mutex);
+    watcher.paths = paths;
+    watcher.modTimes.clear();
+    for (const std::string &path : paths) watcher.modTimes.push_back(GetFileModTime(path.c_str()));
+    watcher.changed = false;
+}
+
+bool ConsumeFileChange(FileWatcher &watcher) { return watcher.changed.exchange(false); }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Polls the modification time of the watched files on a background thread and wakes up the
+// main loop when one changes, so the loop can block on events while nothing is animating.
+struct FileWatcher {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::string> paths;
+    std::vector<long> modTimes;
+    bool running{false};
+    std::atomic<bool> changed{false};
+};
+
+void StartFileWatcher(FileWatcher &watcher);
+void StopFileWatcher(FileWatcher &watcher);
+void WatchFiles(FileWatcher &watcher, const std::vector<std::string> &paths);
+bool ConsumeFileChange(FileWatcher &watcher);
@@ -0,0 +1,40 @@
+#include "folder_browser.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "decode_worker.h"
+
+void BrowseFolderOf(FolderBrowser &browser, const std::string &path) {
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    auto current = std::find(browser.files.begin(), browser.files.end(), path);
+    if (directory == browser.directory && current != browser.files.end()) {
+        browser.index = (int)(current - browser.files.begin());
+        return;
+    }
+
+    browser.directory = directory;
+    browser.files.clear();
+    std::error_code error;
+    for (auto it = std::filesystem::directory_iterator(directory, error);
+         !error && it != std::filesystem::directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file() && IsSheetFile(it->path().string())) browser.files.push_back(it->path().string());
+    }
+    std::sort(browser.files.begin(), browser.files.end());
+
+    // The path may be spelled differently from the listing, or be gone already
+    current = std::find_if(browser.files.begin(), browser.files.end(), [&](const std::string &file) {
+        std::error_code equivalentError;
+        return std::filesystem::equivalent(file, path, equivalentError);
+    });
+    browser.index = current != browser.files.end() ? (int)(current - browser.files.begin()) : -1;
+}
+
+void ClearFolderBrowser(FolderBrowser &browser) { browser = FolderBrowser{}; }
+
+std::string GetBrowsedSheet(const FolderBrowser &browser, int offset) {
+    if (browser.index < 0) return "";
+    int index = browser.index + offset;
+    if (index < 0 || index >= (int)browser.files.size()) return "";
+    return browser.files[index];
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Sheets of the folder the shown sheet was opened from, in file name order
+struct FolderBrowser {
+    std::string directory;
+    std::vector<std::string> files;
+    int index{-1};
+};
+
+// Makes the file the current one, the folder is only listed again when it changes
+void BrowseFolderOf(FolderBrowser &browser, const std::string &path);
+void ClearFolderBrowser(FolderBrowser &browser);
+// Sheet the given number of steps away from the current one, empty past either end
+std::string GetBrowsedSheet(const FolderBrowser &browser, int offset);
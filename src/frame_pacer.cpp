@@ -0,0 +1,72 @@
+#include "frame_pacer.h"
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "raylib.h"
+
+// Time kept in reserve between waking up and the predicted present
+const double LOW_LATENCY_MARGIN = 0.002;
+// Exponential smoothing factor for the reported timings
+const double SMOOTHING = 0.1;
+
+typedef void (*GlFinishProc)(void);
+
+static GlFinishProc glFinishProc = nullptr;
+
+const char *GetPacingModeName(PacingMode mode) {
+    switch (mode) {
+    case PacingMode::VSync:
+        return "VSync";
+    case PacingMode::Uncapped:
+        return "Uncapped";
+    case PacingMode::LowLatency:
+        return "Low latency";
+    }
+    return "";
+}
+
+void InitFramePacer(FramePacer &pacer, PacingMode mode) {
+    int refreshRate = GetMonitorRefreshRate(GetCurrentMonitor());
+    pacer.refreshPeriod = 1.0 / (refreshRate > 0 ? refreshRate : 60);
+    pacer.frameStart = GetTime();
+    glFinishProc = (GlFinishProc)glfwGetProcAddress("glFinish");
+
+    // Waiting is done here, not by raylib
+    SetTargetFPS(0);
+    SetPacingMode(pacer, mode);
+}
+
+void SetPacingMode(FramePacer &pacer, PacingMode mode) {
+    pacer.mode = mode;
+
+    if (mode == PacingMode::Uncapped)
+        ClearWindowState(FLAG_VSYNC_HINT);
+    else
+        SetWindowState(FLAG_VSYNC_HINT);
+}
+
+void EndFrame(FramePacer &pacer) {
+    double swapStart = GetTime();
+    SwapScreenBuffer();
+    // Drivers may return from the swap before the frame is on screen, block until it is so
+    // the present time used for prediction and latency is the real one
+    if (pacer.mode == PacingMode::LowLatency && glFinishProc != nullptr) glFinishProc();
+    double present = GetTime();
+
+    pacer.workTime += (swapStart - pacer.frameStart - pacer.workTime) * SMOOTHING;
+    pacer.latency += (present - pacer.frameStart - pacer.latency) * SMOOTHING;
+
+    if (pacer.mode == PacingMode::LowLatency) {
+        double wakeUp = present + pacer.refreshPeriod - pacer.workTime - LOW_LATENCY_MARGIN;
+        double now = GetTime();
+        if (wakeUp > now) WaitTime(wakeUp - now);
+    }
+
+    PollInputEvents();
+
+    double now = GetTime();
+    pacer.frameTime = now - pacer.frameStart;
+    pacer.frameStart = now;
+}
+
+float GetPacedFrameTime(const FramePacer &pacer) { return (float)pacer.frameTime; }
@@ -0,0 +1,25 @@
+#pragma once
+
+// VSync: present on vertical blank, input is sampled right after the previous present.
+// Uncapped: present as soon as the frame is ready, no waiting at all.
+// LowLatency: present on vertical blank, but input sampling and simulation are delayed
+// until just before the predicted present so the frame shows the freshest input.
+enum class PacingMode { VSync, Uncapped, LowLatency };
+
+struct FramePacer {
+    PacingMode mode{PacingMode::VSync};
+    double refreshPeriod{1.0 / 60.0};
+    double frameStart{0.0};
+    double frameTime{0.0};
+    // Smoothed timings in seconds
+    double workTime{0.0};
+    double latency{0.0};
+};
+
+const char *GetPacingModeName(PacingMode mode);
+void InitFramePacer(FramePacer &pacer, PacingMode mode);
+void SetPacingMode(FramePacer &pacer, PacingMode mode);
+// Presents the frame drawn since the last call, waits as the pacing mode requires and
+// samples input for the next frame. Replaces the swap/wait/poll raylib does in EndDrawing.
+void EndFrame(FramePacer &pacer);
+float GetPacedFrameTime(const FramePacer &pacer);
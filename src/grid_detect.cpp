@@ -0,0 +1,101 @@
+#include "grid_detect.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRID_DETECT_SSE2
+#endif
+
+// Marks which rows and columns hold at least one pixel with a non-zero alpha, in a single
+// pass over the pixels
+static void ScanOccupancy(const Image &image, std::vector<uint8_t> &rows, std::vector<uint8_t> &cols) {
+    const int width = image.width;
+    const int height = image.height;
+    const uint32_t *pixels = static_cast<const uint32_t *>(image.data);
+
+    // Alpha of every column OR-ed over all rows
+    std::vector<uint32_t> colAlpha(width, 0);
+    rows.assign(height, 0);
+
+    for (int y = 0; y < height; y++) {
+        const uint32_t *row = pixels + (size_t)y * width;
+        int x = 0;
+        uint32_t rowAlpha = 0;
+
+#if defined(GRID_DETECT_SSE2)
+        __m128i rowAcc = _mm_setzero_si128();
+        for (; x + 4 <= width; x += 4) {
+            __m128i alpha = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)), 24);
+            __m128i *col = reinterpret_cast<__m128i *>(colAlpha.data() + x);
+            _mm_storeu_si128(col, _mm_or_si128(_mm_loadu_si128(col), alpha));
+            rowAcc = _mm_or_si128(rowAcc, alpha);
+        }
+        rowAlpha = _mm_movemask_epi8(_mm_cmpeq_epi32(rowAcc, _mm_setzero_si128())) != 0xFFFF;
+#endif
+        for (; x < width; x++) {
+            uint32_t alpha = row[x] >> 24;
+            colAlpha[x] |= alpha;
+            rowAlpha |= alpha;
+        }
+
+        rows[y] = rowAlpha != 0;
+    }
+
+    cols.resize(width);
+    for (int x = 0; x < width; x++) cols[x] = colAlpha[x] != 0;
+}
+
+// Finest split of the axis into equal cells where no content crosses a cell border and
+// most cells hold something. Returns 1 when the content leaves no gaps to go by.
+static int DetectAxisFrames(const std::vector<uint8_t> &occupied, int maxFrames) {
+    const int length = (int)occupied.size();
+    int best = 1;
+
+    for (int frames = 2; frames <= maxFrames && frames <= length; frames++) {
+        if (length % frames != 0) continue;
+        int cell = length / frames;
+
+        bool crossed = false;
+        for (int border = cell; border < length && !crossed; border += cell)
+            crossed = occupied[border - 1] && occupied[border];
+        if (crossed) continue;
+
+        int filledCells = 0;
+        for (int start = 0; start < length; start += cell) {
+            for (int i = start; i < start + cell; i++) {
+                if (occupied[i]) {
+                    filledCells++;
+                    break;
+                }
+            }
+        }
+        if (filledCells * 2 >= frames) best = frames;
+    }
+
+    return best;
+}
+
+GridGuess DetectSheetGrid(const Image &image, int maxFrames) {
+    GridGuess guess;
+    if (image.data == nullptr || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return guess;
+
+    std::vector<uint8_t> rows;
+    std::vector<uint8_t> cols;
+    ScanOccupancy(image, rows, cols);
+
+    guess.hFrames = DetectAxisFrames(cols, maxFrames);
+    guess.vFrames = DetectAxisFrames(rows, maxFrames);
+
+    // Slices are often packed tightly enough to touch each other, assume they are square
+    if (guess.hFrames == 1) {
+        int frameHeight = image.height / guess.vFrames;
+        if (frameHeight > 0 && image.width % frameHeight == 0 && image.width / frameHeight <= maxFrames)
+            guess.hFrames = image.width / frameHeight;
+    }
+
+    guess.found = guess.hFrames > 1 || guess.vFrames > 1;
+    return guess;
+}
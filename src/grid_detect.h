@@ -0,0 +1,13 @@
+#pragma once
+
+#include "raylib.h"
+
+struct GridGuess {
+    int hFrames{1};
+    int vFrames{1};
+    bool found{false};
+};
+
+// Proposes the frame grid of a RGBA8 sheet from the fully transparent rows and columns
+// separating its frames. Other formats have no alpha to look at and are not detected.
+GridGuess DetectSheetGrid(const Image &image, int maxFrames);
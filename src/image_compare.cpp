@@ -0,0 +1,42 @@
+#include "image_compare.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+ImageDiff CompareImages(const Image &expected, const Image &actual, int tolerance) {
+    ImageDiff diff;
+    diff.sizeMatches = expected.width == actual.width && expected.height == actual.height;
+    if (!diff.sizeMatches || expected.data == nullptr || actual.data == nullptr) return diff;
+
+    Image expectedPixels = ImageCopy(expected);
+    Image actualPixels = ImageCopy(actual);
+    ImageFormat(&expectedPixels, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    ImageFormat(&actualPixels, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    diff.mask = ImageCopy(expectedPixels);
+    const Color *a = static_cast<const Color *>(expectedPixels.data);
+    const Color *b = static_cast<const Color *>(actualPixels.data);
+    Color *mask = static_cast<Color *>(diff.mask.data);
+
+    int count = expected.width * expected.height;
+    for (int i = 0; i < count; i++) {
+        int difference = std::max({std::abs(a[i].r - b[i].r), std::abs(a[i].g - b[i].g), std::abs(a[i].b - b[i].b),
+                                   std::abs(a[i].a - b[i].a)});
+        diff.maxDifference = std::max(diff.maxDifference, difference);
+        if (difference > tolerance) {
+            diff.differentPixels++;
+            mask[i] = RED;
+        } else {
+            mask[i] = Color{(unsigned char)(a[i].r / 4), (unsigned char)(a[i].g / 4), (unsigned char)(a[i].b / 4), 255};
+        }
+    }
+
+    UnloadImage(expectedPixels);
+    UnloadImage(actualPixels);
+    return diff;
+}
+
+void UnloadImageDiff(ImageDiff &diff) {
+    UnloadImage(diff.mask);
+    diff = ImageDiff{};
+}
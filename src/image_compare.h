@@ -0,0 +1,17 @@
+#pragma once
+
+#include "raylib.h"
+
+// How far an image is from the one it should match, channel by channel
+struct ImageDiff {
+    bool sizeMatches{false};
+    // Pixels with a channel further apart than the tolerance
+    int differentPixels{0};
+    int maxDifference{0};
+    // The expected image dimmed, with the differing pixels in red
+    Image mask{};
+};
+
+// Both images are compared as RGBA8, neither is modified
+ImageDiff CompareImages(const Image &expected, const Image &actual, int tolerance);
+void UnloadImageDiff(ImageDiff &diff);
@@ -0,0 +1,203 @@
+#include "inflate.h"
+
+#include <cstdint>
+#include <cstring>
+
+const int MAX_CODE_BITS = 15;
+const int LITERAL_CODES = 288;
+const int DISTANCE_CODES = 30;
+const int END_OF_BLOCK = 256;
+
+// Base and extra bits of the length and distance codes
+const uint16_t LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,  15,  17,  19,  23, 27,
+                                  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DISTANCE_BASE[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+const uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order the code length code lengths are stored in
+const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct BitReader {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    uint32_t bits;
+    int bitCount;
+    bool ok;
+};
+
+// Canonical Huffman code, the number of codes of every length and the symbols in code order
+struct Huffman {
+    uint16_t counts[MAX_CODE_BITS + 1];
+    uint16_t symbols[LITERAL_CODES];
+};
+
+// Reading past the end yields zeros and clears ok
+static uint32_t ReadBits(BitReader &reader, int count) {
+    while (reader.bitCount < count) {
+        if (reader.pos < reader.size) {
+            reader.bits |= (uint32_t)reader.data[reader.pos++] << reader.bitCount;
+        } else {
+            reader.ok = false;
+        }
+        reader.bitCount += 8;
+    }
+    uint32_t value = reader.bits & ((1u << count) - 1);
+    reader.bits >>= count;
+    reader.bitCount -= count;
+    return value;
+}
+
+// False for an over-subscribed set of lengths, incomplete sets are allowed as the format does
+static bool BuildHuffman(Huffman &huffman, const uint8_t *lengths, int count) {
+    std::memset(huffman.counts, 0, sizeof(huffman.counts));
+    for (int i = 0; i < count; i++) huffman.counts[lengths[i]]++;
+    huffman.counts[0] = 0;
+
+    int left = 1;
+    for (int bits = 1; bits <= MAX_CODE_BITS; bits++) {
+        left = left * 2 - huffman.counts[bits];
+        if (left < 0) return false;
+    }
+
+    uint16_t offsets[MAX_CODE_BITS + 1] = {};
+    for (int bits = 1; bits < MAX_CODE_BITS; bits++) offsets[bits + 1] = offsets[bits] + huffman.counts[bits];
+    for (int i = 0; i < count; i++) {
+        if (lengths[i] != 0) huffman.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+    }
+    return true;
+}
+
+// Codes are stored most significant bit first, one bit is read at a time
+static int DecodeSymbol(BitReader &reader, const Huffman &huffman) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int bits = 1; bits <= MAX_CODE_BITS; bits++) {
+        code |= (int)ReadBits(reader, 1);
+        int count = huffman.counts[bits];
+        if (code - first < count) return huffman.symbols[index + code - first];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static bool InflateBlock(BitReader &reader, const Huffman &literals, const Huffman &distances, unsigned char *output,
+                         size_t outputSize, size_t &written) {
+    while (reader.ok) {
+        int symbol = DecodeSymbol(reader, literals);
+        if (symbol < 0) return false;
+        if (symbol < END_OF_BLOCK) {
+            if (written == outputSize) return false;
+            output[written++] = (unsigned char)symbol;
+            continue;
+        }
+        if (symbol == END_OF_BLOCK) return true;
+
+        symbol -= END_OF_BLOCK + 1;
+        if (symbol >= 29) return false;
+        size_t length = LENGTH_BASE[symbol] + ReadBits(reader, LENGTH_EXTRA[symbol]);
+        int distanceSymbol = DecodeSymbol(reader, distances);
+        if (distanceSymbol < 0 || distanceSymbol >= DISTANCE_CODES) return false;
+        size_t distance = DISTANCE_BASE[distanceSymbol] + ReadBits(reader, DISTANCE_EXTRA[distanceSymbol]);
+        if (distance > written || length > outputSize - written) return false;
+
+        // Byte by byte, the copy may overlap the bytes it produces
+        for (size_t i = 0; i < length; i++, written++) output[written] = output[written - distance];
+    }
+    return false;
+}
+
+static bool ReadDynamicTables(BitReader &reader, Huffman &literals, Huffman &distances) {
+    int literalCount = (int)ReadBits(reader, 5) + 257;
+    int distanceCount = (int)ReadBits(reader, 5) + 1;
+    int codeLengthCount = (int)ReadBits(reader, 4) + 4;
+    if (literalCount > 286 || distanceCount > DISTANCE_CODES) return false;
+
+    uint8_t lengths[LITERAL_CODES + DISTANCE_CODES] = {};
+    for (int i = 0; i < codeLengthCount; i++) lengths[CODE_LENGTH_ORDER[i]] = (uint8_t)ReadBits(reader, 3);
+    Huffman codeLengths;
+    if (!BuildHuffman(codeLengths, lengths, 19)) return false;
+
+    // Literal and distance lengths are one sequence, repeats may cross from one to the other
+    int total = literalCount + distanceCount;
+    std::memset(lengths, 0, sizeof(lengths));
+    for (int i = 0; i < total && reader.ok;) {
+        int symbol = DecodeSymbol(reader, codeLengths);
+        if (symbol < 0) return false;
+        if (symbol < 16) {
+            lengths[i++] = (uint8_t)symbol;
+            continue;
+        }
+
+        uint8_t repeated = 0;
+        int repeat = 0;
+        if (symbol == 16) {
+            if (i == 0) return false;
+            repeated = lengths[i - 1];
+            repeat = 3 + (int)ReadBits(reader, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + (int)ReadBits(reader, 3);
+        } else {
+            repeat = 11 + (int)ReadBits(reader, 7);
+        }
+        if (i + repeat > total) return false;
+        while (repeat-- > 0) lengths[i++] = repeated;
+    }
+    if (lengths[END_OF_BLOCK] == 0) return false;
+
+    return reader.ok && BuildHuffman(literals, lengths, literalCount) &&
+           BuildHuffman(distances, lengths + literalCount, distanceCount);
+}
+
+static void BuildFixedTables(Huffman &literals, Huffman &distances) {
+    uint8_t lengths[LITERAL_CODES];
+    for (int i = 0; i < LITERAL_CODES; i++) lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    BuildHuffman(literals, lengths, LITERAL_CODES);
+    std::memset(lengths, 5, DISTANCE_CODES);
+    BuildHuffman(distances, lengths, DISTANCE_CODES);
+}
+
+bool InflateData(const unsigned char *data, size_t size, unsigned char *output, size_t outputSize) {
+    if (data == nullptr || (output == nullptr && outputSize > 0)) return false;
+
+    BitReader reader{data, size, 0, 0, 0, true};
+    size_t written = 0;
+    bool last = false;
+    while (!last) {
+        last = ReadBits(reader, 1) != 0;
+        uint32_t type = ReadBits(reader, 2);
+        if (!reader.ok) return false;
+
+        if (type == 0) {
+            // Stored blocks start at a byte boundary, whole bytes left in the bit buffer are dropped
+            reader.bits = 0;
+            reader.bitCount = 0;
+            if (size - reader.pos < 4) return false;
+            uint16_t length = (uint16_t)(data[reader.pos] | data[reader.pos + 1] << 8);
+            uint16_t inverse = (uint16_t)(data[reader.pos + 2] | data[reader.pos + 3] << 8);
+            reader.pos += 4;
+            if (length != (uint16_t)~inverse || length > size - reader.pos || length > outputSize - written)
+                return false;
+            if (length > 0) std::memcpy(output + written, data + reader.pos, length);
+            reader.pos += length;
+            written += length;
+            continue;
+        }
+
+        Huffman literals, distances;
+        if (type == 1) {
+            BuildFixedTables(literals, distances);
+        } else if (type != 2 || !ReadDynamicTables(reader, literals, distances)) {
+            return false;
+        }
+        if (!InflateBlock(reader, literals, distances, output, outputSize, written)) return false;
+    }
+    return written == outputSize;
+}
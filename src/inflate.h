@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+// Decodes a raw DEFLATE stream (RFC 1951, no zlib or gzip header) into a buffer of the size the
+// caller expects. Fails on a malformed stream and on one that doesn't fill the output exactly.
+bool InflateData(const unsigned char *data, size_t size, unsigned char *output, size_t outputSize);
@@ -0,0 +1,267 @@
+#include "input_session.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "raylib.h"
+
+const char INPUT_SESSION_MAGIC[4] = {'M', 'S', 'I', 'S'};
+const uint32_t INPUT_SESSION_VERSION = 1;
+
+struct InputSessionHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t frameCount;
+    uint32_t eventCount;
+    uint32_t dropPathCount;
+};
+
+// raylib's own callbacks, the recorder passes everything on to them and the replay calls them
+// with the recorded events
+struct RaylibCallbacks {
+    GLFWkeyfun key{nullptr};
+    GLFWcharfun character{nullptr};
+    GLFWmousebuttonfun mouseButton{nullptr};
+    GLFWcursorposfun cursorPos{nullptr};
+    GLFWscrollfun scroll{nullptr};
+    GLFWdropfun drop{nullptr};
+};
+
+static InputSession *activeSession = nullptr;
+static RaylibCallbacks raylibCallbacks;
+
+static void RecordEvent(InputEventType type, int action, int mods, int code, float x, float y) {
+    activeSession->events.push_back({type, (uint8_t)action, (uint16_t)mods, code, x, y});
+}
+
+static void KeyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if (activeSession->mode != SessionMode::Record) return;
+    RecordEvent(InputEventType::Key, action, mods, key, 0.0f, 0.0f);
+    raylibCallbacks.key(window, key, scancode, action, mods);
+}
+
+static void CharCallback(GLFWwindow *window, unsigned int codepoint) {
+    if (activeSession->mode != SessionMode::Record) return;
+    RecordEvent(InputEventType::Char, 0, 0, (int)codepoint, 0.0f, 0.0f);
+    raylibCallbacks.character(window, codepoint);
+}
+
+static void MouseButtonCallback(GLFWwindow *window, int button, int action, int mods) {
+    if (activeSession->mode != SessionMode::Record) return;
+    RecordEvent(InputEventType::MouseButton, action, mods, button, 0.0f, 0.0f);
+    raylibCallbacks.mouseButton(window, button, action, mods);
+}
+
+static void CursorPosCallback(GLFWwindow *window, double x, double y) {
+    if (activeSession->mode != SessionMode::Record) return;
+    RecordEvent(InputEventType::CursorPos, 0, 0, 0, (float)x, (float)y);
+    raylibCallbacks.cursorPos(window, x, y);
+}
+
+static void ScrollCallback(GLFWwindow *window, double x, double y) {
+    if (activeSession->mode != SessionMode::Record) return;
+    RecordEvent(InputEventType::Scroll, 0, 0, 0, (float)x, (float)y);
+    raylibCallbacks.scroll(window, x, y);
+}
+
+static void DropCallback(GLFWwindow *window, int count, const char **paths) {
+    if (activeSession->mode != SessionMode::Record) return;
+    RecordEvent(InputEventType::Drop, 0, 0, count, 0.0f, 0.0f);
+    activeSession->dropPaths.insert(activeSession->dropPaths.end(), paths, paths + count);
+    raylibCallbacks.drop(window, count, paths);
+}
+
+static void HookCallbacks(InputSession &session) {
+    GLFWwindow *window = glfwGetCurrentContext();
+    activeSession = &session;
+    raylibCallbacks.key = glfwSetKeyCallback(window, KeyCallback);
+    raylibCallbacks.character = glfwSetCharCallback(window, CharCallback);
+    raylibCallbacks.mouseButton = glfwSetMouseButtonCallback(window, MouseButtonCallback);
+    raylibCallbacks.cursorPos = glfwSetCursorPosCallback(window, CursorPosCallback);
+    raylibCallbacks.scroll = glfwSetScrollCallback(window, ScrollCallback);
+    raylibCallbacks.drop = glfwSetDropCallback(window, DropCallback);
+}
+
+static void UnhookCallbacks() {
+    GLFWwindow *window = glfwGetCurrentContext();
+    glfwSetKeyCallback(window, raylibCallbacks.key);
+    glfwSetCharCallback(window, raylibCallbacks.character);
+    glfwSetMouseButtonCallback(window, raylibCallbacks.mouseButton);
+    glfwSetCursorPosCallback(window, raylibCallbacks.cursorPos);
+    glfwSetScrollCallback(window, raylibCallbacks.scroll);
+    glfwSetDropCallback(window, raylibCallbacks.drop);
+    raylibCallbacks = RaylibCallbacks{};
+    activeSession = nullptr;
+}
+
+// Hands a recorded event to raylib as if GLFW had just polled it
+static void PlayEvent(InputSession &session, const InputEvent &event) {
+    GLFWwindow *window = glfwGetCurrentContext();
+
+    switch (event.type) {
+    case InputEventType::Key:
+        raylibCallbacks.key(window, event.code, 0, event.action, event.mods);
+        break;
+    case InputEventType::Char:
+        raylibCallbacks.character(window, (unsigned int)event.code);
+        break;
+    case InputEventType::MouseButton:
+        raylibCallbacks.mouseButton(window, event.code, event.action, event.mods);
+        break;
+    case InputEventType::CursorPos:
+        raylibCallbacks.cursorPos(window, event.x, event.y);
+        break;
+    case InputEventType::Scroll:
+        raylibCallbacks.scroll(window, event.x, event.y);
+        break;
+    case InputEventType::Drop: {
+        std::vector<const char *> paths;
+        for (int i = 0; i < event.code && session.nextDropPath < session.dropPaths.size(); i++)
+            paths.push_back(session.dropPaths[session.nextDropPath++].c_str());
+        raylibCallbacks.drop(window, (int)paths.size(), paths.data());
+        break;
+    }
+    }
+}
+
+static bool SaveInputSession(const InputSession &session) {
+    InputSessionHeader header{};
+    std::memcpy(header.magic, INPUT_SESSION_MAGIC, 4);
+    header.version = INPUT_SESSION_VERSION;
+    header.frameCount = (uint32_t)session.frames.size();
+    header.eventCount = (uint32_t)session.events.size();
+    header.dropPathCount = (uint32_t)session.dropPaths.size();
+
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(session.path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+    std::string tempPath = session.path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(session.frames.data()), session.frames.size() * sizeof(InputFrame));
+        file.write(reinterpret_cast<const char *>(session.events.data()), session.events.size() * sizeof(InputEvent));
+        // Paths are length prefixed
+        for (const std::string &path : session.dropPaths) {
+            uint32_t length = (uint32_t)path.size();
+            file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            file.write(path.data(), length);
+        }
+        if (!file) return false;
+    }
+
+    std::filesystem::rename(tempPath, session.path, error);
+    return !error;
+}
+
+static bool LoadInputSession(InputSession &session) {
+    std::ifstream file(session.path, std::ios::binary);
+    InputSessionHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, INPUT_SESSION_MAGIC, 4) != 0 || header.version != INPUT_SESSION_VERSION)
+        return false;
+
+    session.frames.resize(header.frameCount);
+    session.events.resize(header.eventCount);
+    file.read(reinterpret_cast<char *>(session.frames.data()), session.frames.size() * sizeof(InputFrame));
+    file.read(reinterpret_cast<char *>(session.events.data()), session.events.size() * sizeof(InputEvent));
+    for (uint32_t i = 0; i < header.dropPathCount && file; i++) {
+        uint32_t length = 0;
+        file.read(reinterpret_cast<char *>(&length), sizeof(length));
+        std::string path(file ? length : 0, '\0');
+        file.read(path.data(), path.size());
+        session.dropPaths.push_back(std::move(path));
+    }
+    if (!file) return false;
+
+    // Every event belongs to a frame
+    size_t eventCount = 0;
+    for (const InputFrame &frame : session.frames) eventCount += frame.eventCount;
+    return eventCount == session.events.size();
+}
+
+void StartInputRecording(InputSession &session, const std::string &path) {
+    session = InputSession{};
+    session.mode = SessionMode::Record;
+    session.path = path;
+    HookCallbacks(session);
+}
+
+bool StartInputReplay(InputSession &session, const std::string &path) {
+    session = InputSession{};
+    session.path = path;
+    if (!LoadInputSession(session)) {
+        TraceLog(LOG_WARNING, "REPLAY: [%s] Not a recorded session", path.c_str());
+        session = InputSession{};
+        return false;
+    }
+
+    session.mode = SessionMode::Replay;
+    session.measuredTimes.reserve(session.frames.size());
+    HookCallbacks(session);
+    return true;
+}
+
+bool UpdateInputSession(InputSession &session, float &frameTime) {
+    switch (session.mode) {
+    case SessionMode::Off:
+        return true;
+    case SessionMode::Record: {
+        // Everything polled since the previous frame
+        size_t pending = session.events.size() - session.frameEvent;
+        session.frames.push_back({frameTime, (uint16_t)std::min(pending, (size_t)UINT16_MAX), 0});
+        session.frameEvent += session.frames.back().eventCount;
+        return true;
+    }
+    case SessionMode::Replay: {
+        if (session.nextFrame >= session.frames.size()) return false;
+        // The time of the previous frame, the first one includes startup
+        if (session.nextFrame > 0) session.measuredTimes.push_back(frameTime);
+
+        const InputFrame &frame = session.frames[session.nextFrame++];
+        for (int i = 0; i < frame.eventCount; i++) PlayEvent(session, session.events[session.frameEvent++]);
+        frameTime = frame.frameTime;
+        return true;
+    }
+    }
+    return true;
+}
+
+void RecordDecodedSheet(InputSession &session) {
+    if (session.mode == SessionMode::Record && !session.frames.empty()) session.frames.back().sheetCount++;
+}
+
+int GetReplayedSheetCount(const InputSession &session) {
+    if (session.mode != SessionMode::Replay || session.nextFrame == 0) return 0;
+    return session.frames[session.nextFrame - 1].sheetCount;
+}
+
+bool StopInputSession(InputSession &session) {
+    bool saved = true;
+
+    if (session.mode == SessionMode::Record) {
+        saved = SaveInputSession(session);
+        TraceLog(saved ? LOG_INFO : LOG_WARNING, "RECORD: [%s] %d frames, %d events %s", session.path.c_str(),
+                 (int)session.frames.size(), (int)session.events.size(), saved ? "saved" : "could not be saved");
+    } else if (session.mode == SessionMode::Replay && !session.measuredTimes.empty()) {
+        std::vector<float> times = session.measuredTimes;
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (float time : times) total += time;
+        size_t count = times.size();
+        TraceLog(LOG_INFO, "REPLAY: [%s] %d frames, %.2f ms average, %.2f ms median, %.2f ms 99th percentile, "
+                           "%.2f ms worst",
+                 session.path.c_str(), (int)count, total * 1000.0 / count, times[count / 2] * 1000.0,
+                 times[count * 99 / 100] * 1000.0, times.back() * 1000.0);
+    }
+
+    if (session.mode != SessionMode::Off) UnhookCallbacks();
+    session.mode = SessionMode::Off;
+    return saved;
+}
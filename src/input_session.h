@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class SessionMode { Off, Record, Replay };
+
+enum class InputEventType : uint8_t { Key, Char, MouseButton, CursorPos, Scroll, Drop };
+
+// One call of a GLFW input callback
+struct InputEvent {
+    InputEventType type;
+    uint8_t action;
+    uint16_t mods;
+    // Key, codepoint, mouse button or number of dropped paths
+    int32_t code;
+    // Cursor position or scroll offset
+    float x;
+    float y;
+};
+
+struct InputFrame {
+    // Time the frame simulated, in seconds
+    float frameTime;
+    // Events polled right before the frame
+    uint16_t eventCount;
+    // Decoded sheets the frame picked up
+    uint16_t sheetCount;
+};
+
+static_assert(sizeof(InputEvent) == 16 && sizeof(InputFrame) == 8, "The records are part of the file format");
+
+// Input of every frame of a session as raylib received it from GLFW, along with the frame
+// times, so a replay drives the application through the same states at the same frames
+struct InputSession {
+    SessionMode mode{SessionMode::Off};
+    std::string path;
+    std::vector<InputFrame> frames;
+    std::vector<InputEvent> events;
+    // Paths of every drop, in order
+    std::vector<std::string> dropPaths;
+    // Recorded events not given to a frame yet, or the replay position
+    size_t frameEvent{0};
+    size_t nextFrame{0};
+    size_t nextDropPath{0};
+    // Frame times measured during the replay, in seconds
+    std::vector<float> measuredTimes;
+};
+
+// Both hook into the callbacks raylib installed, so the window must be open. A replay swallows
+// the live input of the window.
+void StartInputRecording(InputSession &session, const std::string &path);
+bool StartInputReplay(InputSession &session, const std::string &path);
+// Called at the start of every frame with its measured frame time, before any clamping.
+// Recording logs the frame, replaying feeds its input to raylib and swaps in the recorded frame
+// time. False once the replay is over.
+bool UpdateInputSession(InputSession &session, float &frameTime);
+// Counts a decoded sheet towards the recorded frame
+void RecordDecodedSheet(InputSession &session);
+// Decoded sheets the replayed frame has to pick up
+int GetReplayedSheetCount(const InputSession &session);
+// Saves the recording, or logs the frame times of the replay
+bool StopInputSession(InputSession &session);
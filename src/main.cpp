@@ -1,19 +1,47 @@
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
-#include "font_data.h"
-#include "pixel_shader.h"
+#include "assets.h"
+#include "config_cache.h"
+#include "decode_worker.h"
+#include "file_watcher.h"
+#include "folder_browser.h"
+#include "frame_pacer.h"
+#include "hash.h"
+#include "image_compare.h"
+#include "input_session.h"
+#include "mipmaps.h"
+#include "profiler.h"
+#include "qoi_writer.h"
+#include "shader_cache.h"
+#include "sheet_layout.h"
+#include "slice_trim.h"
+#include "stack_batch.h"
+#include "texture_compress.h"
+#include "texture_manager.h"
+#include "ui_font.h"
+#include "voxel_volume.h"
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
 #include "raylib.h"
+#include "rlgl.h"
 
 const int WIDTH = 500;
 const int HEIGHT = 375;
+// Sheets of the browsed folder decoded ahead on each side of the shown one
+const int PREFETCH_DISTANCE = 2;
 const std::unordered_map<int, std::tuple<Color, int>> bkgColors = {{0, {LIGHTGRAY, 0x828282FF}},
                                                                    {1, {DARKGRAY, 0xC8C8C8FF}}};
 
@@ -25,11 +53,25 @@ struct AppState {
     bool vFramesEditMode{false};
     int vFramesValue{1};
     int tempVFramesValue{1};
+    // LayoutOrder of the slices
+    int layoutValue{0};
     bool frameEditMode{false};
     int framesValue{0};
     bool playAnimChecked{false};
     bool rotationChecked{true};
     bool pixelizerChecked{false};
+    bool depthChecked{false};
+    bool bakeChecked{false};
+    bool bakeAnglesEditMode{false};
+    int bakeAnglesValue{64};
+    bool voxelChecked{false};
+    float voxelPitchValue{45.0f};
+    // Zoom eases towards its target, spacing is the distance between slices in texels
+    float zoomValue{8.0f};
+    float targetZoomValue{8.0f};
+    float spacingValue{1.0f};
+    bool mipmapsChecked{false};
+    bool compressChecked{false};
     int bkgColorId{0};
     Color backgroundColor = LIGHTGRAY;
     int textColor{static_cast<int>(0x828282FF)};
@@ -42,79 +84,461 @@ struct AppState {
 
 struct Sprite {
     std::string path;
-    long modTime;
-    Texture2D tex;
-    Vector2 origin;
+    long modTime{0};
+    Texture2D tex{};
     float rotation{0};
-    Rectangle texRec;
-    std::vector<Rectangle> drawRecs;
+    Rectangle texRec{};
     int currentFrame{0};
+    uint64_t contentHash{0};
+    // Slice files the sheet was packed from, empty for a single sheet file
+    std::vector<std::string> slicePaths;
+    // Grid and frame duration given by the file or detected, proposed when there is no config
+    GridGuess grid;
+    LayoutOrder layout{LayoutOrder::RowMajor};
+    float frameDuration{0.0f};
+    // Decode options the texture was requested with, it may have fewer levels or stay RGBA8
+    bool mipmaps{false};
+    bool compress{false};
+    // Visible area of every (slice, frame) cell, indexed frame * slices + slice
+    AlphaMask alphaMask;
+    std::vector<Rectangle> trimRecs;
+    SheetLayout trimLayout{LayoutOrder::RowMajor, 0, 0};
 };
 
-Sprite CreateSprite() {
-    Texture2D tex;
-    std::string path = "";
-    long modTime;
+// Sprites of the browsed folder kept on the GPU, so flipping to them needs no decoding. Their
+// textures are the first the texture manager evicts, least recently cached first.
+struct SheetCache {
+    std::unordered_map<std::string, Sprite> sprites;
+};
+
+// The stack pre-rendered at evenly spaced angles, one atlas cell per angle
+struct RotationBake {
+    RenderTexture2D atlas{};
+    int angles{0};
+    int columns{0};
+    Vector2 cellSize{0, 0};
+    // Where a cell lands on screen, cells are scaled down when the atlas would be too large
+    Rectangle dest{0, 0, 0, 0};
+    // What the bake was rendered from
+    unsigned int texId{0};
+    uint64_t contentHash{0};
+    SheetLayout layout{LayoutOrder::RowMajor, 0, 0};
+    int frame{-1};
+    bool depth{false};
+    float zoom{0.0f};
+    float spacing{0.0f};
+};
+
+// Ray-marched voxel volume of the current frame, drawn at a fraction of the window size
+struct VoxelView {
+    RunLengthVolume volume;
+    Image image{};
+    Texture2D tex{};
+    ThreadPool pool;
+    // What the volume was built from
+    unsigned int texId{0};
+    uint64_t contentHash{0};
+    SheetLayout layout{LayoutOrder::RowMajor, 0, 0};
+    int frame{-1};
+};
+
+// Slices of the current frame on the GPU
+struct StackSlices {
+    StackBatch batch;
+    // What the slices were uploaded from
+    unsigned int texId{0};
+    uint64_t contentHash{0};
+    SheetLayout layout{LayoutOrder::RowMajor, 0, 0};
+    int frame{-1};
+};
+
+struct Renderer {
+    TextureManager textures;
+    // Only allocated once a post effect needs it
+    RenderTexture2D target{};
+    ShaderCache shaders;
+    Shader pixelShader{};
+    StackSlices stack;
+    RotationBake bake;
+    VoxelView voxels;
+};
+
+// On-disk caches live next to the executable
+std::string GetCachePath(const std::string &fileName) {
+    return (std::filesystem::path(GetApplicationDirectory()) / "cache" / fileName).string();
+}
+
+// Uploads the image of a decoded sheet and releases it. Mipmapped sheets are filtered
+// between levels when zoomed out and keep the sharp pixels when zoomed in. Compressed chains
+// may stop before 1x1.
+Texture2D UploadSheetImage(TextureManager &textures, DecodedSheet &sheet) {
+    Texture2D tex{};
+    if (sheet.image.data == nullptr) return tex;
+
+    tex = LoadManagedTexture(textures, sheet.image);
+    if (tex.mipmaps > 1) {
+        rlTextureParameters(tex.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_MIP_LINEAR);
+        rlTextureParameters(tex.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_NEAREST);
+        if (tex.format == PIXELFORMAT_COMPRESSED_DXT5_RGBA) LimitTextureLevels(tex);
+    }
+    UnloadImage(sheet.image);
+    sheet.image = Image{};
+    return tex;
+}
+
+Sprite CreateSprite(TextureManager &textures, DecodedSheet &sheet) {
+    Texture2D tex = UploadSheetImage(textures, sheet);
+
+    Sprite sprite{sheet.path, sheet.modTime, tex};
+    sprite.slicePaths = sheet.slicePaths;
+    sprite.grid = sheet.grid;
+    sprite.layout = sheet.layout;
+    sprite.frameDuration = sheet.frameDuration;
+    sprite.mipmaps = sheet.mipmaps;
+    sprite.compress = sheet.compress;
+    sprite.contentHash = sheet.contentHash;
+    sprite.alphaMask = std::move(sheet.alphaMask);
+    return sprite;
+}
+
+// Decodes on the calling thread alone
+Sprite LoadSprite(TextureManager &textures, const std::string &path) {
+    ThreadPool inlinePool;
+    DecodedSheet sheet = DecodeSheet(path, false, false, inlinePool);
+    return CreateSprite(textures, sheet);
+}
+
+// A sheet keeping its size and format is uploaded into the texture it had
+void UpdateModifiedSprite(TextureManager &textures, Sprite &sprite, DecodedSheet &sheet) {
+    if (sheet.image.data != nullptr) {
+        UnloadManagedTexture(textures, sprite.tex);
+        sprite.tex = UploadSheetImage(textures, sheet);
+    }
+
+    sprite.modTime = sheet.modTime;
+    sprite.mipmaps = sheet.mipmaps;
+    sprite.compress = sheet.compress;
+    sprite.contentHash = sheet.contentHash;
+    sprite.alphaMask = std::move(sheet.alphaMask);
+    sprite.trimLayout.slices = 0;
+}
+
+// Files to decode or watch for the sprite
+std::vector<std::string> GetSpriteFiles(const Sprite &sprite) {
+    if (!sprite.slicePaths.empty()) return sprite.slicePaths;
+    return {sprite.path};
+}
+
+void UnloadCachedSprite(TextureManager &textures, SheetCache &cache, const std::string &path) {
+    auto cached = cache.sprites.find(path);
+    if (cached == cache.sprites.end()) return;
+    UnloadManagedTexture(textures, cached->second.tex);
+    cache.sprites.erase(cached);
+}
+
+void UnloadSheetCache(TextureManager &textures, SheetCache &cache) {
+    while (!cache.sprites.empty()) UnloadCachedSprite(textures, cache, cache.sprites.begin()->first);
+}
 
-    FilePathList droppedFile = LoadDroppedFiles();
+// Takes over the texture of the sprite, a sprite already cached under the same path is replaced
+void StoreCachedSprite(TextureManager &textures, SheetCache &cache, Sprite sprite) {
+    if (sprite.tex.id == 0) return;
+    UnloadCachedSprite(textures, cache, sprite.path);
+    std::string path = sprite.path;
+    Texture2D tex = sprite.tex;
+    cache.sprites[path] = std::move(sprite);
+    SetTextureEvictable(textures, tex, [&textures, &cache, path] { UnloadCachedSprite(textures, cache, path); });
+}
+
+// Hands the sprite over to the caller, unless the file changed since it was cached
+bool TakeCachedSprite(TextureManager &textures, SheetCache &cache, const std::string &path, Sprite &sprite) {
+    auto cached = cache.sprites.find(path);
+    if (cached == cache.sprites.end()) return false;
+    if (cached->second.modTime != GetFileModTime(path.c_str())) {
+        UnloadCachedSprite(textures, cache, path);
+        return false;
+    }
+
+    sprite = std::move(cached->second);
+    cache.sprites.erase(cached);
+    // Shown sprites stay resident
+    SetTextureEvictable(textures, sprite.tex, nullptr);
+    return true;
+}
+
+// A value box has the keyboard
+bool IsEditingValue(const AppState &state) {
+    return state.hFramesEditMode || state.vFramesEditMode || state.frameEditMode || state.frameSpeedEditMode ||
+           state.bakeAnglesEditMode;
+}
 
-    if (droppedFile.count == 1) {
-        path = droppedFile.paths[0];
-        modTime = GetFileModTime(droppedFile.paths[0]);
+SheetLayout GetSheetLayout(const AppState &state) {
+    return MakeSheetLayout((LayoutOrder)state.layoutValue, state.hFramesValue, state.vFramesValue);
+}
 
-        Image tempImg = LoadImage(droppedFile.paths[0]);
-        ImageFlipVertical(&tempImg);
+void TrimSpriteSlices(Sprite &sprite, const SheetLayout &layout) {
+    Vector2 cellSize = GetLayoutCellSize(layout, sprite.tex.width, sprite.tex.height);
 
-        if (tempImg.data != nullptr) {
-            UnloadTexture(tex);
-            tex = LoadTextureFromImage(tempImg);
+    sprite.trimRecs.clear();
+    for (int frame = 0; frame < layout.frames; frame++) {
+        for (int slice = 0; slice < layout.slices; slice++) {
+            Rectangle cell = GetLayoutCell(layout, cellSize, slice, frame);
+            sprite.trimRecs.push_back(GetOpaqueBounds(sprite.alphaMask, cell));
         }
     }
 
-    UnloadDroppedFiles(droppedFile);
+    sprite.trimLayout = layout;
+}
+
+void UpdateSpriteFrames(Sprite &sprite, const SheetLayout &layout) {
+    Vector2 cellSize = GetLayoutCellSize(layout, sprite.tex.width, sprite.tex.height);
+    sprite.texRec = {0.0f, 0.0f, cellSize.x, cellSize.y};
+    sprite.currentFrame = std::min(sprite.currentFrame, layout.frames - 1);
+
+    // The tight bounds only change with the grid or the image, not every frame
+    if (sprite.trimLayout != layout) TrimSpriteSlices(sprite, layout);
+}
 
-    return Sprite{path, modTime, tex};
+StackView GetStackView(const AppState &state, const Sprite &sprite) {
+    StackView view;
+    view.center = {WIDTH / 2.0f, HEIGHT / 2.0f};
+    view.rotation = sprite.rotation;
+    view.zoom = state.zoomValue;
+    view.spacing = state.spacingValue;
+    return view;
 }
 
-void UpdateModifiedSprite(Sprite &sprite) {
-    Image tempImg = LoadImage(sprite.path.c_str());
-    ImageFlipVertical(&tempImg);
+// Draws only the visible part of every slice, the quad keeps its place relative to the
+// rotation pivot of the full frame. The slices are uploaded once per frame of the sheet and
+// drawn in one instanced call, zoom and spacing are shader uniforms so changing the view costs
+// nothing on the CPU.
+// With depth testing the slices go top to bottom with alpha-tested opaque pixels, so every
+// screen pixel is shaded about once instead of once per covering slice. Output is the same
+// for pixel art whose alpha is either 0 or 255.
+void DrawSpriteStack(Renderer &renderer, const AppState &state, Sprite &sprite) {
+    size_t slices = sprite.trimLayout.slices;
+    size_t frameOffset = (size_t)sprite.currentFrame * slices;
+    if (slices == 0 || frameOffset + slices > sprite.trimRecs.size()) return;
 
-    if (tempImg.data != nullptr) {
-        UnloadTexture(sprite.tex);
-        sprite.tex = LoadTextureFromImage(tempImg);
+    StackSlices &stack = renderer.stack;
+    bool current = stack.texId == sprite.tex.id && stack.contentHash == sprite.contentHash &&
+                   stack.layout == sprite.trimLayout &&
+                   stack.frame == sprite.currentFrame && stack.batch.reversed == state.depthChecked;
+    Vector2 cellSize = {sprite.texRec.width, sprite.texRec.height};
+    if (!current) {
+        std::vector<Vector2> cells(slices);
+        for (size_t slice = 0; slice < slices; slice++) {
+            Rectangle cell = GetLayoutCell(sprite.trimLayout, cellSize, (int)slice, sprite.currentFrame);
+            cells[slice] = {cell.x, cell.y};
+        }
+        UpdateStackBatch(stack.batch, &sprite.trimRecs[frameOffset], cells.data(), (int)slices, state.depthChecked);
+        stack.texId = sprite.tex.id;
+        stack.contentHash = sprite.contentHash;
+        stack.layout = sprite.trimLayout;
+        stack.frame = sprite.currentFrame;
     }
+
+    int mipLevels = GetGridMipLevels((int)cellSize.x, (int)cellSize.y, sprite.tex.mipmaps);
+    DrawStackBatch(stack.batch, sprite.tex, cellSize, mipLevels, GetStackView(state, sprite), state.depthChecked);
+}
+
+const int MAX_BAKE_ATLAS_SIZE = 4096;
+
+bool IsBakeCurrent(const RotationBake &bake, const AppState &state, const Sprite &sprite) {
+    return bake.atlas.id != 0 && bake.angles == state.bakeAnglesValue && bake.texId == sprite.tex.id &&
+           bake.contentHash == sprite.contentHash && bake.layout == GetSheetLayout(state) &&
+           bake.frame == sprite.currentFrame && bake.depth == state.depthChecked &&
+           bake.zoom == state.zoomValue && bake.spacing == state.spacingValue;
+}
+
+void UnloadRotationBake(TextureManager &textures, RotationBake &bake) {
+    UnloadManagedRenderTexture(textures, bake.atlas);
+    bake = RotationBake{};
 }
 
-void UpdateSpriteFrames(Sprite &sprite, uint32_t hFrames, uint32_t vFrames, float scale) {
-    uint32_t frameWidth = sprite.tex.width / hFrames;
-    uint32_t frameHeight = sprite.tex.height / vFrames;
+// Renders the current frame of the stack at every baked angle with the live stacking code
+void BakeSpriteRotations(Renderer &renderer, const AppState &state, Sprite &sprite) {
+    RotationBake &bake = renderer.bake;
+    UnloadRotationBake(renderer.textures, bake);
+    int slices = sprite.trimLayout.slices;
+    if (slices == 0) return;
 
-    if (!sprite.drawRecs.empty()) sprite.drawRecs.clear();
+    // Any rotation of a slice stays inside the circle around its pivot
+    StackView view = GetStackView(state, sprite);
+    float radius = 0.5f * view.zoom * sqrtf(sprite.texRec.width * sprite.texRec.width +
+                                            sprite.texRec.height * sprite.texRec.height);
+    float lift = view.spacing * view.zoom;
+    float minY = view.center.y + (0.5f * slices - (slices - 1)) * lift;
+    float maxY = view.center.y + 0.5f * slices * lift;
+    Rectangle area = {view.center.x - radius, minY - radius, 2.0f * radius, maxY - minY + 2.0f * radius};
 
-    for (auto i = 0; i < hFrames; i++) {
-        Rectangle rec = {WIDTH / 2.0f, ((HEIGHT / 2.0f) + hFrames * 4) - (i * 8), (float)frameWidth * scale,
-                         (float)frameHeight * scale};
-        sprite.drawRecs.push_back(rec);
+    int angles = state.bakeAnglesValue;
+    int columns = (int)ceilf(sqrtf((float)angles));
+    int rows = (angles + columns - 1) / columns;
+    float resolution = std::min({1.0f, MAX_BAKE_ATLAS_SIZE / (columns * area.width),
+                                 MAX_BAKE_ATLAS_SIZE / (rows * area.height)});
+    Vector2 cellSize = {ceilf(area.width * resolution), ceilf(area.height * resolution)};
+
+    bake.atlas = LoadManagedRenderTexture(renderer.textures, (int)cellSize.x * columns, (int)cellSize.y * rows);
+    bake.angles = angles;
+    bake.columns = columns;
+    bake.cellSize = cellSize;
+    bake.dest = {area.x, area.y, cellSize.x / resolution, cellSize.y / resolution};
+    bake.texId = sprite.tex.id;
+    bake.contentHash = sprite.contentHash;
+    bake.layout = GetSheetLayout(state);
+    bake.frame = sprite.currentFrame;
+    bake.depth = state.depthChecked;
+    bake.zoom = state.zoomValue;
+    bake.spacing = state.spacingValue;
+
+    // Straight alpha blending into a transparent target would leave src.a * src.a as alpha. The
+    // colour is blended as usual and alpha adds up as src.a + dst.a * (1 - src.a), the atlas then
+    // holds premultiplied colour and is drawn as such.
+    float rotation = sprite.rotation;
+    BeginTextureMode(bake.atlas);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD,
+                              RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    for (int k = 0; k < angles; k++) {
+        Camera2D camera = {};
+        camera.offset = {(k % columns) * cellSize.x, (k / columns) * cellSize.y};
+        camera.target = {area.x, area.y};
+        camera.zoom = resolution;
+
+        sprite.rotation = k * 360.0f / angles;
+        BeginMode2D(camera);
+        DrawSpriteStack(renderer, state, sprite);
+        EndMode2D();
     }
+    EndBlendMode();
+    EndTextureMode();
+    sprite.rotation = rotation;
+}
 
-    sprite.texRec = {0.0f, 0.0f, (float)frameWidth, (float)frameHeight};
-    sprite.origin = {(frameWidth * scale) / 2.0f, (frameHeight * scale) / 2.0f};
+// Plays back the rotation with a single quad from the nearest baked angle
+void DrawBakedStack(const RotationBake &bake, float rotation) {
+    float turn = fmodf(rotation, 360.0f);
+    if (turn < 0.0f) turn += 360.0f;
+    int k = (int)lroundf(turn * bake.angles / 360.0f) % bake.angles;
+
+    // Render textures are stored bottom up
+    float x = (k % bake.columns) * bake.cellSize.x;
+    float y = (k / bake.columns) * bake.cellSize.y;
+    Rectangle source = {x, bake.atlas.texture.height - y - bake.cellSize.y, bake.cellSize.x, -bake.cellSize.y};
+    // The atlas colour is premultiplied by its alpha
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTexturePro(bake.atlas.texture, source, bake.dest, Vector2{0, 0}, 0.0f, WHITE);
+    EndBlendMode();
 }
 
-void ChangeBkgColor(AppState &state) {
-    size_t colors = bkgColors.size();
-    int nextColor = state.bkgColorId + 1 >= colors ? 0 : state.bkgColorId + 1;
-    state.bkgColorId = nextColor;
+const int VOXEL_RENDER_DIVISOR = 2;
+
+void UnloadVoxelView(TextureManager &textures, VoxelView &view) {
+    UnloadManagedTexture(textures, view.tex);
+    UnloadImage(view.image);
+    StopThreadPool(view.pool);
+    view.tex = Texture2D{};
+    view.image = Image{};
+    view.volume = RunLengthVolume{};
+    view.frame = -1;
+}
+
+// The volume is built once per frame of the sheet from a readback of the texture
+void UpdateVoxelView(TextureManager &textures, VoxelView &view, const AppState &state, const Sprite &sprite) {
+    if (view.tex.id == 0) {
+        view.image = GenImageColor(WIDTH / VOXEL_RENDER_DIVISOR, HEIGHT / VOXEL_RENDER_DIVISOR, BLANK);
+        view.tex = LoadManagedTexture(textures, view.image);
+        StartThreadPool(view.pool);
+    }
+
+    bool current = view.texId == sprite.tex.id && view.contentHash == sprite.contentHash &&
+                   view.layout == GetSheetLayout(state) && view.frame == sprite.currentFrame;
+    if (current) return;
+
+    Image sheet = LoadImageFromSheetTexture(sprite.tex);
+    ImageFormat(&sheet, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    view.volume = BuildRunLengthVolume(sheet, GetSheetLayout(state), sprite.currentFrame);
+    UnloadImage(sheet);
+
+    view.texId = sprite.tex.id;
+    view.contentHash = sprite.contentHash;
+    view.layout = GetSheetLayout(state);
+    view.frame = sprite.currentFrame;
+}
+
+void DrawVoxelView(VoxelView &view, const AppState &state, const Sprite &sprite) {
+    VoxelCamera camera;
+    camera.yaw = sprite.rotation;
+    camera.pitch = state.voxelPitchValue;
+    camera.zoom = state.zoomValue / VOXEL_RENDER_DIVISOR;
 
-    Color bkgColor = std::get<0>(bkgColors.at(nextColor));
-    int textColor = std::get<1>(bkgColors.at(nextColor));
+    RenderRunLengthVolume(view.volume, camera, view.image, view.pool);
+    UpdateTexture(view.tex, view.image.data);
+    DrawTexturePro(view.tex, Rectangle{0, 0, (float)view.tex.width, (float)view.tex.height},
+                   Rectangle{0, 0, WIDTH, HEIGHT}, Vector2{0, 0}, 0.0f, WHITE);
+}
+
+// Baked playback is only used for still frames, animation would need a bake per frame
+void DrawPreviewStack(Renderer &renderer, const AppState &state, Sprite &sprite) {
+    if (state.voxelChecked && sprite.tex.id != 0) {
+        UpdateVoxelView(renderer.textures, renderer.voxels, state, sprite);
+        DrawVoxelView(renderer.voxels, state, sprite);
+    } else if (state.bakeChecked && !state.playAnimChecked && IsBakeCurrent(renderer.bake, state, sprite))
+        DrawBakedStack(renderer.bake, sprite.rotation);
+    else
+        DrawSpriteStack(renderer, state, sprite);
+}
+
+void SetBkgColor(AppState &state, int colorId) {
+    state.bkgColorId = colorId;
+
+    Color bkgColor = std::get<0>(bkgColors.at(colorId));
+    int textColor = std::get<1>(bkgColors.at(colorId));
 
     state.backgroundColor = bkgColor;
     state.textColor = textColor;
     GuiSetStyle(DEFAULT, TEXT_COLOR_NORMAL, state.textColor);
 }
 
+void ChangeBkgColor(AppState &state) {
+    size_t colors = bkgColors.size();
+    int nextColor = state.bkgColorId + 1 >= colors ? 0 : state.bkgColorId + 1;
+    SetBkgColor(state, nextColor);
+}
+
+SheetConfig GetSheetConfig(const AppState &state) {
+    SheetConfig config;
+    config.hFrames = (int16_t)state.hFramesValue;
+    config.vFrames = (int16_t)state.vFramesValue;
+    config.layout = (uint8_t)state.layoutValue;
+    config.frameDuration = state.frameSpeedValue;
+    config.rotation = state.rotationChecked;
+    config.pixelizer = state.pixelizerChecked;
+    config.depthTest = state.depthChecked;
+    config.bkgColorId = state.bkgColorId;
+    return config;
+}
+
+void ApplySheetConfig(AppState &state, const SheetConfig &config) {
+    state.tempHFramesValue = state.hFramesValue = config.hFrames;
+    state.tempVFramesValue = state.vFramesValue = config.vFrames;
+    state.layoutValue = std::min((int)config.layout, (int)LayoutOrder::SliceGrid);
+    // Same range as the spinner
+    state.frameSpeedValue = std::min(std::max(config.frameDuration, 0.1f), 1.0f);
+    state.rotationChecked = config.rotation != 0;
+    state.pixelizerChecked = config.pixelizer != 0;
+    state.depthChecked = config.depthTest != 0;
+    if (bkgColors.count(config.bkgColorId) != 0) SetBkgColor(state, config.bkgColorId);
+}
+
+// Remembers the configuration of the open sheet, unless it is still being configured
+void StoreSpriteConfig(ConfigCache &cache, const AppState &state, const Sprite &sprite) {
+    if (sprite.tex.id == 0 || state.configMode) return;
+    StoreSheetConfig(cache, HashString(sprite.path), sprite.contentHash, GetSheetConfig(state));
+}
+
 void DrawConfigMode(AppState &state) {
     if (GuiSpinner(Rectangle{390, 10, 100, 24}, "H-Frames ", &state.tempHFramesValue, 1, 100,
                    state.hFramesEditMode)) {
@@ -124,7 +548,8 @@ void DrawConfigMode(AppState &state) {
                    state.vFramesEditMode)) {
         state.vFramesEditMode = !state.vFramesEditMode;
     }
-    if (GuiButton(Rectangle{390, 70, 100, 24}, "Confirm")) state.configMode = false;
+    GuiComboBox(Rectangle{390, 70, 100, 24}, "Row-major;Col-major;Slice grid", &state.layoutValue);
+    if (GuiButton(Rectangle{390, 100, 100, 24}, "Confirm")) state.configMode = false;
 
     // Sprite frame size
     auto size = std::to_string((int)state.frameSize.x) + "x" + std::to_string((int)state.frameSize.y);
@@ -134,8 +559,9 @@ void DrawConfigMode(AppState &state) {
     state.vFramesValue = state.tempVFramesValue <= 0 ? 1 : state.tempVFramesValue;
 }
 
-void DrawPreviewMode(AppState &state, Sprite &sprite) {
-    if (GuiSpinner(Rectangle{390, 10, 100, 24}, "Frame ", &sprite.currentFrame, 0, state.vFramesValue - 1,
+void DrawPreviewMode(AppState &state, Sprite &sprite, const Renderer &renderer) {
+    const RotationBake &bake = renderer.bake;
+    if (GuiSpinner(Rectangle{390, 10, 100, 24}, "Frame ", &sprite.currentFrame, 0, GetSheetLayout(state).frames - 1,
                    state.frameEditMode)) {
         state.frameEditMode = !state.frameEditMode;
     }
@@ -148,6 +574,19 @@ void DrawPreviewMode(AppState &state, Sprite &sprite) {
     GuiCheckBox(Rectangle{390, 70, 24, 24}, " Rotate", &state.rotationChecked);
 
     GuiCheckBox(Rectangle{390, 100, 24, 24}, " Pixelizer", &state.pixelizerChecked);
+
+    GuiCheckBox(Rectangle{390, 190, 24, 24}, " Depth", &state.depthChecked);
+
+    GuiCheckBox(Rectangle{390, 220, 24, 24}, " Baked", &state.bakeChecked);
+    if (state.bakeChecked) {
+        // More angles give a smoother rotation for more memory
+        if (GuiSpinner(Rectangle{390, 250, 100, 24}, "Angles ", &state.bakeAnglesValue, 4, 360,
+                       state.bakeAnglesEditMode)) {
+            state.bakeAnglesEditMode = !state.bakeAnglesEditMode;
+        }
+        auto memory = TextFormat("%.1f MB", bake.atlas.texture.width * bake.atlas.texture.height * 8 / 1e6f);
+        GuiLabel(Rectangle{390, 280, 100, 24}, memory);
+    }
     // TODO: Changing the background's color makes everything else hard to read or see.
     if (GuiButton(Rectangle{390, 130, 100, 24}, "#29#Bkg")) ChangeBkgColor(state);
 
@@ -157,103 +596,842 @@ void DrawPreviewMode(AppState &state, Sprite &sprite) {
         if (GuiButton(Rectangle{390, 160, 100, 24}, "#149#Stop")) state.playAnimChecked = false;
     }
 
+    auto zoom = TextFormat("Zoom %.2fx (Wheel)", state.targetZoomValue);
+    GuiLabel(Rectangle{10, 282, 160, 24}, zoom);
+
+    // Zoomed out stacks sample smaller copies of the sheet, applied by reloading it
+    GuiCheckBox(Rectangle{10, 252, 24, 24}, " Mipmaps", &state.mipmapsChecked);
+    // DXT5 takes a quarter of the memory, the quality loss is logged as PSNR
+    GuiCheckBox(Rectangle{100, 252, 24, 24}, " Compressed", &state.compressChecked);
+
+    // Voxel view with adjustable pitch, the stacks have adjustable spacing instead
+    GuiCheckBox(Rectangle{10, 342, 24, 24}, " Voxels", &state.voxelChecked);
+    if (state.voxelChecked) {
+        auto pitch = TextFormat("Pitch %d (Up/Down)", (int)state.voxelPitchValue);
+        GuiLabel(Rectangle{10, 312, 160, 24}, pitch);
+
+        // Size of the spans next to what a dense RGBA8 grid would take
+        const RunLengthVolume &volume = renderer.voxels.volume;
+        size_t size = GetRunLengthVolumeSize(volume);
+        size_t denseSize = (size_t)volume.sizeX * volume.sizeY * volume.sizeZ * 4;
+        if (size > 0) {
+            auto memory = TextFormat("%d KB (%.1fx smaller)", (int)(size / 1024), (float)denseSize / size);
+            GuiLabel(Rectangle{100, 342, 160, 24}, memory);
+        }
+    } else {
+        auto spacing = TextFormat("Spacing %.2f (Up/Down)", state.spacingValue);
+        GuiLabel(Rectangle{10, 312, 160, 24}, spacing);
+    }
+
     if (GuiButton(Rectangle{466, 312, 24, 24}, "#44#")) state.uiVisibilityChecked = false;
 
     if (GuiButton(Rectangle{466, 342, 24, 24}, "#142#")) state.configMode = true;
 }
 
-int main() {
+// Renders the same stack straight to the backbuffer, through an offscreen target, with depth
+// testing and from a rotation bake, then reports the average frame time of each path. The
+// voxel view is ray-marched from the dense and the run-length volume for comparison.
+int RunRenderBenchmark(const std::string &path, int hFrames, int vFrames, int frames) {
+    AppState state;
+    state.hFramesValue = hFrames;
+    state.vFramesValue = vFrames;
+
+    InitWindow(WIDTH, HEIGHT, "MotionStaker - Benchmark");
+    FramePacer pacer;
+    InitFramePacer(pacer, PacingMode::Uncapped);
+
+    Renderer renderer;
+    Sprite sprite = LoadSprite(renderer.textures, path);
+    if (sprite.tex.id == 0) {
+        std::cerr << "Could not load " << path << std::endl;
+        CloseWindow();
+        return 1;
+    }
+    UpdateSpriteFrames(sprite, GetSheetLayout(state));
+
+    renderer.target = LoadManagedRenderTexture(renderer.textures, WIDTH, HEIGHT);
+    InitShaderCache(renderer.shaders, GetCachePath("shaders"));
+    LoadStackBatch(renderer.stack.batch, renderer.shaders);
+
+    auto measure = [&](bool offscreen, bool depth, bool baked) {
+        state.depthChecked = depth;
+        state.bakeChecked = baked;
+        double start = GetTime();
+        for (int f = 0; f < frames; f++) {
+            sprite.rotation += 1.0f;
+            if (offscreen) {
+                BeginTextureMode(renderer.target);
+                ClearBackground(state.backgroundColor);
+                DrawSpriteStack(renderer, state, sprite);
+                EndTextureMode();
+            }
+            BeginDrawing();
+            ClearBackground(state.backgroundColor);
+            if (offscreen) {
+                DrawTextureRec(renderer.target.texture,
+                               Rectangle{0, 0, (float)renderer.target.texture.width,
+                                         (float)-renderer.target.texture.height},
+                               Vector2{0, 0}, WHITE);
+            } else {
+                DrawPreviewStack(renderer, state, sprite);
+            }
+            EndDrawing();
+            EndFrame(pacer);
+        }
+        return (GetTime() - start) * 1000.0 / frames;
+    };
+
+    double direct = measure(false, false, false);
+    double offscreen = measure(true, false, false);
+    double depth = measure(false, true, false);
+
+    state.depthChecked = false;
+    double bakeStart = GetTime();
+    BakeSpriteRotations(renderer, state, sprite);
+    double bakeTime = (GetTime() - bakeStart) * 1000.0;
+    double baked = measure(false, false, true);
+
+    Image sheet = LoadImageFromTexture(sprite.tex);
+    ImageFormat(&sheet, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    VoxelVolume denseVolume = BuildVoxelVolume(sheet, GetSheetLayout(state), 0);
+    RunLengthVolume runLengthVolume = BuildRunLengthVolume(sheet, GetSheetLayout(state), 0);
+    UnloadImage(sheet);
+
+    Image voxelImage = GenImageColor(WIDTH / VOXEL_RENDER_DIVISOR, HEIGHT / VOXEL_RENDER_DIVISOR, BLANK);
+    ThreadPool pool;
+    StartThreadPool(pool);
+    VoxelCamera camera;
+    camera.zoom = state.zoomValue / VOXEL_RENDER_DIVISOR;
+    auto measureVoxels = [&](bool runLength) {
+        camera.yaw = 0.0f;
+        double start = GetTime();
+        for (int f = 0; f < frames; f++) {
+            camera.yaw += 1.0f;
+            if (runLength)
+                RenderRunLengthVolume(runLengthVolume, camera, voxelImage, pool);
+            else
+                RenderVoxelVolume(denseVolume, camera, voxelImage, pool);
+        }
+        return (GetTime() - start) * 1000.0 / frames;
+    };
+    double voxelDense = measureVoxels(false);
+    double voxelRunLength = measureVoxels(true);
+    StopThreadPool(pool);
+    UnloadImage(voxelImage);
+
+    size_t denseSize = denseVolume.voxels.size() * sizeof(uint32_t);
+    size_t runLengthSize = GetRunLengthVolumeSize(runLengthVolume);
+
+    // Zoomed out, from the base level and then from the mip chain
+    state.zoomValue = 0.25f;
+    double zoomedOut = measure(false, false, false);
+    ThreadPool inlinePool;
+    DecodedSheet mipmapped = DecodeSheet(path, true, true, inlinePool);
+    UnloadManagedTexture(renderer.textures, sprite.tex);
+    sprite.tex = UploadSheetImage(renderer.textures, mipmapped);
+    double zoomedOutMipmapped = measure(false, false, false);
+
+    // The mipmapped sheet again as DXT5, when the driver takes it
+    double zoomedOutCompressed = 0.0;
+    CompressionResult compression;
+    if (IsTextureCompressionSupported()) {
+        DecodedSheet compressed = DecodeSheet(path, true, true, inlinePool);
+        compression = CompressImageDxt5(compressed.image, compressed.contentHash, "", inlinePool);
+        if (compression.compressed) {
+            UnloadManagedTexture(renderer.textures, sprite.tex);
+            sprite.tex = UploadSheetImage(renderer.textures, compressed);
+            zoomedOutCompressed = measure(false, false, false);
+        }
+        UnloadImage(compressed.image);
+    }
+
+    float fullArea = sprite.texRec.width * sprite.texRec.height * hFrames;
+    float trimmedArea = 0.0f;
+    for (int i = 0; i < hFrames; i++) trimmedArea += sprite.trimRecs[i].width * sprite.trimRecs[i].height;
+
+    std::cout << "Stack of " << hFrames << " slices, " << frames << " frames" << std::endl;
+    std::cout << "  trimmed quads cover " << 100.0f * trimmedArea / fullArea << "% of the full slices"
+              << std::endl;
+    std::cout << "  direct:    " << direct << " ms/frame" << std::endl;
+    std::cout << "  offscreen: " << offscreen << " ms/frame" << std::endl;
+    std::cout << "  depth:     " << depth << " ms/frame" << std::endl;
+    std::cout << "  baked:     " << baked << " ms/frame (" << state.bakeAnglesValue << " angles baked in "
+              << bakeTime << " ms)" << std::endl;
+    std::cout << "  voxels:    " << voxelDense << " ms/frame dense (" << denseSize / 1024 << " KB), "
+              << voxelRunLength << " ms/frame run-length (" << runLengthSize / 1024 << " KB, "
+              << (float)denseSize / std::max(runLengthSize, (size_t)1) << "x smaller)" << std::endl;
+    std::cout << "  zoomed out: " << zoomedOut << " ms/frame, " << zoomedOutMipmapped << " ms/frame mipmapped (at "
+              << state.zoomValue << "x)" << std::endl;
+    if (compression.compressed)
+        std::cout << "  compressed: " << zoomedOutCompressed << " ms/frame mipmapped DXT5 ("
+                  << GetTextureMemorySize(sprite.tex) / 1024 << " KB, " << compression.psnr << " dB PSNR)"
+                  << std::endl;
+    else
+        std::cout << "  compressed: not measured, DXT5 is unsupported or the sheet is not made of 4x4 blocks"
+                  << std::endl;
+
+    UnloadRotationBake(renderer.textures, renderer.bake);
+    UnloadVoxelView(renderer.textures, renderer.voxels);
+    UnloadStackBatch(renderer.stack.batch);
+    UnloadManagedRenderTexture(renderer.textures, renderer.target);
+    UnloadManagedTexture(renderer.textures, sprite.tex);
+    UnloadTextureManager(renderer.textures);
+    CloseWindow();
+
+    return 0;
+}
+
+// Per channel difference left to drivers rounding the slice blending differently
+const int GOLDEN_TOLERANCE = 2;
+// Exit code of a check that had no golden image to compare some cases with, ctest reports it as skipped
+const int GOLDEN_SKIPPED = 77;
+
+// Renders every case listed in <directory>/golden.txt offscreen through the stacked renderer
+// and compares it with its golden image, so changes to the draw path can be checked to leave
+// the output as it was. A case line is "<sheet> <h-frames> <v-frames> <rotation> <frame>",
+// followed by any of "depth", "mipmaps", "baked" and "zoom=<x>" to pick the render path and one
+// of "row-major", "column-major" and "slice-grid" for the layout, lines starting with # are
+// skipped. Rotation and frame are fixed, nothing depends on time. With update set the golden
+// images are written instead. Returns the number of failed cases, cases without a golden image
+// are counted in missing and don't fail.
+int RunGoldenCheck(const std::string &directory, bool update, int &missing) {
+    std::filesystem::path root(directory);
+    char *manifest = LoadFileText((root / "golden.txt").string().c_str());
+    if (manifest == nullptr) {
+        std::cerr << "No golden.txt in " << directory << std::endl;
+        return 1;
+    }
+    std::istringstream lines(manifest);
+    UnloadFileText(manifest);
+
+    // Nothing is presented, the hidden window only provides the context
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(WIDTH, HEIGHT, "MotionStaker - Golden");
+
+    Renderer renderer;
+    renderer.target = LoadManagedRenderTexture(renderer.textures, WIDTH, HEIGHT);
+    InitShaderCache(renderer.shaders, GetCachePath("shaders"));
+    LoadStackBatch(renderer.stack.batch, renderer.shaders);
+
+    int cases = 0;
+    int failures = 0;
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string sheet;
+        AppState state;
+        float rotation = 0.0f;
+        int frame = 0;
+        if (!(fields >> sheet) || sheet[0] == '#') continue;
+        if (!(fields >> state.hFramesValue >> state.vFramesValue >> rotation >> frame)) {
+            std::cerr << "Malformed case: " << line << std::endl;
+            failures++;
+            continue;
+        }
+
+        // Every option also names the golden image
+        bool mipmaps = false;
+        bool known = true;
+        std::string option, options;
+        while (fields >> option) {
+            if (option == "depth")
+                state.depthChecked = true;
+            else if (option == "mipmaps")
+                mipmaps = true;
+            else if (option == "baked")
+                state.bakeChecked = true;
+            else if (option == "row-major")
+                state.layoutValue = (int)LayoutOrder::RowMajor;
+            else if (option == "column-major")
+                state.layoutValue = (int)LayoutOrder::ColumnMajor;
+            else if (option == "slice-grid")
+                state.layoutValue = (int)LayoutOrder::SliceGrid;
+            else if (option.rfind("zoom=", 0) == 0)
+                state.zoomValue = state.targetZoomValue = std::strtof(option.c_str() + 5, nullptr);
+            else
+                known = false;
+            options += "_" + option;
+        }
+        if (!known || state.zoomValue <= 0.0f) {
+            std::cerr << "Malformed case: " << line << std::endl;
+            failures++;
+            continue;
+        }
+        cases++;
+
+        std::string name = TextFormat("%s_%g_%d", GetFileNameWithoutExt(sheet.c_str()), rotation, frame) + options;
+        std::string goldenPath = (root / (name + ".png")).string();
+        ThreadPool inlinePool;
+        DecodedSheet decoded = DecodeSheet((root / sheet).string(), false, mipmaps, inlinePool);
+        Sprite sprite = CreateSprite(renderer.textures, decoded);
+        if (sprite.tex.id == 0) {
+            std::cerr << name << ": could not load " << sheet << std::endl;
+            failures++;
+            continue;
+        }
+        sprite.rotation = rotation;
+        sprite.currentFrame = std::max(frame, 0);
+        UpdateSpriteFrames(sprite, GetSheetLayout(state));
+        if (state.bakeChecked) BakeSpriteRotations(renderer, state, sprite);
+
+        BeginTextureMode(renderer.target);
+        ClearBackground(state.backgroundColor);
+        DrawPreviewStack(renderer, state, sprite);
+        EndTextureMode();
+        // Render textures are stored bottom up
+        Image output = LoadImageFromTexture(renderer.target.texture);
+        ImageFlipVertical(&output);
+        UnloadRotationBake(renderer.textures, renderer.bake);
+        UnloadManagedTexture(renderer.textures, sprite.tex);
+
+        if (update) {
+            if (!ExportImage(output, goldenPath.c_str())) failures++;
+            std::cout << name << ": updated" << std::endl;
+            UnloadImage(output);
+            continue;
+        }
+
+        Image golden = LoadImage(goldenPath.c_str());
+        ImageDiff diff = CompareImages(golden, output, GOLDEN_TOLERANCE);
+        if (golden.data == nullptr) {
+            std::cout << name << ": skipped, no golden image" << std::endl;
+            missing++;
+        } else if (!diff.sizeMatches) {
+            std::cout << name << ": FAILED, golden image is " << golden.width << "x" << golden.height << std::endl;
+            failures++;
+        } else if (diff.differentPixels > 0) {
+            // The differing pixels are written next to the golden image
+            ExportImage(diff.mask, (root / (name + ".diff.png")).string().c_str());
+            std::cout << name << ": FAILED, " << diff.differentPixels << " pixels differ by up to "
+                      << diff.maxDifference << std::endl;
+            failures++;
+        } else {
+            std::cout << name << ": passed" << std::endl;
+        }
+        UnloadImageDiff(diff);
+        UnloadImage(golden);
+        UnloadImage(output);
+    }
+    std::cout << std::max(cases - failures - missing, 0) << " of " << cases << " cases passed";
+    if (missing > 0) std::cout << ", " << missing << " skipped, update_goldens writes their golden images";
+    std::cout << std::endl;
+
+    UnloadStackBatch(renderer.stack.batch);
+    UnloadManagedRenderTexture(renderer.textures, renderer.target);
+    UnloadTextureManager(renderer.textures);
+    CloseWindow();
+
+    return failures;
+}
+
+// The contact sheet is a grid of square thumbnails, rendered one band of rows at a time
+const int CONTACT_THUMB_SIZE = 128;
+const int CONTACT_COLUMNS = 16;
+const int CONTACT_BAND_ROWS = 4;
+// Sheets decoded ahead of the renderer fill one band, at most two bands of thumbnails are held
+const int CONTACT_BATCH = CONTACT_COLUMNS * CONTACT_BAND_ROWS;
+const float CONTACT_ROTATION = 30.0f;
+const Color CONTACT_BACKGROUND = LIGHTGRAY;
+
+// A sheet with its grid resolved, cells larger than a thumbnail are scaled down to one
+struct ContactThumb {
+    DecodedSheet sheet;
+    AppState state;
+};
+
+// Runs on a pool thread, only the thumbnail sized image is kept
+ContactThumb LoadContactThumb(const std::string &path, const ConfigCache &configCache) {
+    ContactThumb thumb;
+    ThreadPool inlinePool;
+    thumb.sheet = DecodeSheet(path, false, false, inlinePool);
+
+    AppState &state = thumb.state;
+    SheetConfig config;
+    if (FindSheetConfig(configCache, HashString(path), thumb.sheet.contentHash, config)) {
+        ApplySheetConfig(state, config);
+    } else {
+        state.hFramesValue = thumb.sheet.grid.hFrames;
+        state.vFramesValue = thumb.sheet.grid.vFrames;
+        state.layoutValue = (int)thumb.sheet.layout;
+    }
+    // Thumbnails don't overlap, sorting their slices buys nothing
+    state.depthChecked = false;
+
+    Image &image = thumb.sheet.image;
+    if (image.data == nullptr) return thumb;
+    SheetLayout layout = GetSheetLayout(state);
+    Vector2 cellSize = GetLayoutCellSize(layout, image.width, image.height);
+    float scale = CONTACT_THUMB_SIZE / std::max(cellSize.x, cellSize.y);
+    if (scale < 1.0f) {
+        // Whole pixel cells keep the grid lined up, spacing shrinks with them so the fit is unchanged
+        int cellWidth = std::max(1, (int)(cellSize.x * scale));
+        int cellHeight = std::max(1, (int)(cellSize.y * scale));
+        ImageResizeNN(&image, cellWidth * GetLayoutColumns(layout), cellHeight * GetLayoutRows(layout));
+        thumb.sheet.alphaMask = BuildAlphaMask(image);
+        state.spacingValue *= scale;
+    }
+    return thumb;
+}
+
+// Renders every sheet found under a directory as a rotated stack thumbnail, with its file name,
+// into one QOI image. Sheets are decoded on all cores one band ahead of the renderer and scaled
+// down to thumbnail size there, each band is read back and appended to the file, so memory stays
+// the same for any number or size of files. The stored configuration of a sheet gives its grid,
+// the detected grid is used otherwise.
+int RunContactSheet(const std::string &directory, const std::string &output) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file() && IsSheetFile(it->path().string())) paths.push_back(it->path().string());
+    }
+    if (paths.empty()) {
+        std::cerr << "No sheets found in " << directory << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::string outputPath = output;
+    if (std::filesystem::path(outputPath).extension() != ".qoi") outputPath += ".qoi";
+    std::string tempPath = outputPath + ".tmp";
+    // Every sheet takes a cell, failed ones too, so the size of the image is known before the first band
+    int rows = (int)((paths.size() + CONTACT_COLUMNS - 1) / CONTACT_COLUMNS);
+    QoiWriter writer;
+    if (!OpenQoiWriter(writer, tempPath, CONTACT_COLUMNS * CONTACT_THUMB_SIZE, rows * CONTACT_THUMB_SIZE)) {
+        std::cerr << "Could not write " << outputPath << std::endl;
+        return 1;
+    }
+
+    ConfigCache configCache;
+    LoadConfigCache(configCache, GetCachePath("sheets.bin"));
+    ThreadPool pool;
+    StartThreadPool(pool);
+
+    // Each sheet is decoded on a single thread, the pool runs several of them at once
+    auto decodeBatch = [&](size_t first) {
+        std::vector<ContactThumb> batch(std::min((size_t)CONTACT_BATCH, paths.size() - first));
+        ParallelFor(pool, (int)batch.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; i++) batch[i] = LoadContactThumb(paths[first + i], configCache);
+        });
+        return batch;
+    };
+
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(WIDTH, HEIGHT, "MotionStaker - Contact Sheet");
+
+    Renderer renderer;
+    InitShaderCache(renderer.shaders, GetCachePath("shaders"));
+    LoadStackBatch(renderer.stack.batch, renderer.shaders);
+    RenderTexture2D band = LoadManagedRenderTexture(renderer.textures, CONTACT_COLUMNS * CONTACT_THUMB_SIZE,
+                                                    CONTACT_BAND_ROWS * CONTACT_THUMB_SIZE);
+
+    int failed = 0;
+    std::vector<ContactThumb> next = decodeBatch(0);
+    for (size_t first = 0; first < paths.size(); first += CONTACT_BATCH) {
+        std::vector<ContactThumb> batch = std::move(next);
+        std::thread decoding;
+        if (first + CONTACT_BATCH < paths.size())
+            decoding = std::thread([&] { next = decodeBatch(first + CONTACT_BATCH); });
+
+        BeginTextureMode(band);
+        ClearBackground(CONTACT_BACKGROUND);
+        EndTextureMode();
+
+        for (int cell = 0; cell < (int)batch.size(); cell++) {
+            DecodedSheet &sheet = batch[cell].sheet;
+            AppState &state = batch[cell].state;
+            std::string name = GetFileName(sheet.path.c_str());
+            Sprite sprite = CreateSprite(renderer.textures, sheet);
+
+            BeginTextureMode(band);
+            if (sprite.tex.id != 0) {
+                UpdateSpriteFrames(sprite, GetSheetLayout(state));
+                sprite.rotation = CONTACT_ROTATION;
+
+                // The stack fits its cell at any rotation
+                float diagonal = sqrtf(sprite.texRec.width * sprite.texRec.width +
+                                       sprite.texRec.height * sprite.texRec.height);
+                float height = diagonal + sprite.trimLayout.slices * state.spacingValue;
+                state.zoomValue = 0.8f * CONTACT_THUMB_SIZE / std::max(diagonal, height);
+
+                Camera2D camera = {};
+                camera.offset = {(cell % CONTACT_COLUMNS + 0.5f) * CONTACT_THUMB_SIZE,
+                                 (cell / CONTACT_COLUMNS + 0.5f) * CONTACT_THUMB_SIZE};
+                camera.target = {WIDTH / 2.0f, HEIGHT / 2.0f};
+                camera.zoom = 1.0f;
+
+                BeginMode2D(camera);
+                DrawSpriteStack(renderer, state, sprite);
+                EndMode2D();
+            } else {
+                std::cerr << "Could not load " << sprite.path << std::endl;
+                failed++;
+            }
+            // Long names keep their start
+            DrawText(TextSubtext(name.c_str(), 0, 20), (cell % CONTACT_COLUMNS) * CONTACT_THUMB_SIZE + 4,
+                     (cell / CONTACT_COLUMNS + 1) * CONTACT_THUMB_SIZE - 14, 10, DARKGRAY);
+            EndTextureMode();
+            // Sheets of the same size land in the same texture
+            if (sprite.tex.id != 0) UnloadManagedTexture(renderer.textures, sprite.tex);
+        }
+
+        Image image = LoadImageFromTexture(band.texture);
+        // Render textures are stored bottom up, the last band ends with its last row
+        ImageFlipVertical(&image);
+        int bandRows = std::min(CONTACT_BAND_ROWS, rows - (int)(first / CONTACT_COLUMNS));
+        WriteQoiPixels(writer, (const uint8_t *)image.data, (size_t)image.width * bandRows * CONTACT_THUMB_SIZE);
+        UnloadImage(image);
+
+        if (decoding.joinable()) decoding.join();
+    }
+
+    std::error_code renameError;
+    bool written = CloseQoiWriter(writer);
+    if (written) std::filesystem::rename(tempPath, outputPath, renameError);
+    if (!written || renameError) {
+        std::cerr << "Could not write " << outputPath << std::endl;
+        std::filesystem::remove(tempPath, renameError);
+        failed = (int)paths.size();
+    }
+    std::cout << paths.size() - failed << " of " << paths.size() << " sheets in " << outputPath << std::endl;
+
+    UnloadManagedRenderTexture(renderer.textures, band);
+    UnloadStackBatch(renderer.stack.batch);
+    UnloadTextureManager(renderer.textures);
+    CloseWindow();
+    StopThreadPool(pool);
+    UnloadConfigCache(configCache);
+
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    // Usage: MotionStaker --bench <spritesheet> <h-frames> <v-frames> [frames]
+    if (argc >= 5 && std::string(argv[1]) == "--bench") {
+        int frames = argc >= 6 ? std::stoi(argv[5]) : 1000;
+        return RunRenderBenchmark(argv[2], std::stoi(argv[3]), std::stoi(argv[4]), frames);
+    }
+    // Usage: MotionStaker --golden <directory> [--update]
+    if (argc >= 3 && std::string(argv[1]) == "--golden") {
+        bool update = argc >= 4 && std::string(argv[3]) == "--update";
+        int missing = 0;
+        if (RunGoldenCheck(argv[2], update, missing) > 0) return 1;
+        return missing > 0 ? GOLDEN_SKIPPED : 0;
+    }
+    // Usage: MotionStaker --contact <directory> <output>
+    if (argc >= 4 && std::string(argv[1]) == "--contact") return RunContactSheet(argv[2], argv[3]);
+    // Usage: MotionStaker --startup
+    bool startupOnly = argc >= 2 && std::string(argv[1]) == "--startup";
+    // Usage: MotionStaker --record <session> or MotionStaker --replay <session>
+    std::string recordPath = argc >= 3 && std::string(argv[1]) == "--record" ? argv[2] : "";
+    std::string replayPath = argc >= 3 && std::string(argv[1]) == "--replay" ? argv[2] : "";
+    // Sessions start without any stored sheet configuration, so opened sheets come up the same
+    bool sessionActive = !recordPath.empty() || !replayPath.empty();
+    // Usage: MotionStaker [--texture-budget <megabytes>] [--texture-cache-budget <megabytes>], also
+    // after --record or --replay
+    Renderer renderer;
+    DecodeWorker decoder;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--texture-budget")
+            renderer.textures.budget = (size_t)std::stoi(argv[i + 1]) << 20;
+        if (std::string(argv[i]) == "--texture-cache-budget")
+            decoder.textureCacheBudget = (uint64_t)std::stoi(argv[i + 1]) << 20;
+    }
+
     bool spriteLoaded = false;
-    size_t frameCount{0};
+    bool eventWaiting = false;
+    bool mipmapsRequested = false;
+    bool compressRequested = false;
+    float animTime{0.0f};
     AppState state;
     Sprite mainSprite;
+    FileWatcher watcher;
+    FramePacer pacer;
+    Profiler profiler;
+    ConfigCache configCache;
+    InputSession session;
+    SheetCache sheetCache;
+    FolderBrowser browser;
+    // Sheet of the folder flipped to before it was decoded
+    std::string browsedPath;
+
+    BeginStartupProfile(profiler.startup);
+
+    // Work that needs no GL context runs while the window opens
+    std::string configPath = GetCachePath("sheets.bin");
+    UiFontData fontData;
+    double configTime = 0.0;
+    double fontTime = 0.0;
+    std::thread background([&] {
+        auto start = std::chrono::steady_clock::now();
+        if (!sessionActive) LoadConfigCache(configCache, configPath);
+        auto loaded = std::chrono::steady_clock::now();
+        fontData = DecodeUiFont();
+        configTime = std::chrono::duration<double, std::milli>(loaded - start).count();
+        fontTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loaded).count();
+    });
+    StartFileWatcher(watcher);
+    decoder.textureCache = GetCachePath("textures");
+    StartDecodeWorker(decoder);
+    MarkStartupStage(profiler.startup, "worker threads");
 
     InitWindow(WIDTH, HEIGHT, "MotionStaker");
-    SetTargetFPS(60);
+    InitFramePacer(pacer, PacingMode::VSync);
     SetWindowState(FLAG_WINDOW_TOPMOST);
+    MarkStartupStage(profiler.startup, "window");
+    // Without it the sheets stay RGBA8 whatever the checkbox says
+    bool compressionSupported = IsTextureCompressionSupported();
+    if (!compressionSupported) TraceLog(LOG_INFO, "COMPRESS: DXT5 textures not supported, sheets stay RGBA8");
 
-    RenderTexture2D target = LoadRenderTexture(WIDTH, HEIGHT);
+    // Programs linked on an earlier run come back from the cache without compiling
+    InitShaderCache(renderer.shaders, GetCachePath("shaders"));
+    renderer.pixelShader =
+        LoadCachedShader(renderer.shaders, GetAssetText(default_vert), GetAssetText(pixelizer_frag));
+    LoadStackBatch(renderer.stack.batch, renderer.shaders);
+    MarkStartupStage(profiler.startup, "shaders");
+    TraceLog(LOG_INFO, "SHADER: %d programs loaded from the cache, %d compiled", renderer.shaders.hits,
+             renderer.shaders.misses);
 
-    Shader pixelShader = LoadShaderFromMemory(nullptr, pixelizer_frag);
+    background.join();
+    MarkStartupStage(profiler.startup, "background wait");
+    AddBackgroundStage(profiler.startup, "config cache", configTime);
+    AddBackgroundStage(profiler.startup, "font decode", fontTime);
 
-    Font ubuFont = LoadFontFromMemory(".ttf", ___assets_Ubuntu_Regular_ttf, ___assets_Ubuntu_Regular_ttf_len,
-                                      17, nullptr, 0);
+    Font ubuFont = UploadUiFont(fontData);
     GuiSetFont(ubuFont);
-    GuiSetStyle(DEFAULT, TEXT_SIZE, 17);
+    GuiSetStyle(DEFAULT, TEXT_SIZE, ubuFont.baseSize);
     GuiSetStyle(DEFAULT, TEXT_COLOR_NORMAL, state.textColor);
     GuiSetStyle(DEFAULT, BASE_COLOR_NORMAL, 0x444444FF);
+    MarkStartupStage(profiler.startup, "font upload");
+
+    if (!recordPath.empty()) StartInputRecording(session, recordPath);
+    if (!replayPath.empty()) {
+        if (!StartInputReplay(session, replayPath))
+            std::cerr << "Could not load the session " << replayPath << std::endl;
+        // Frames take as long as they cost, with the timings on screen
+        SetPacingMode(pacer, PacingMode::Uncapped);
+        profiler.visible = true;
+    }
+
+    // Replaces the shown sprite, the sheet config decides between the preview and the config panel
+    auto showSprite = [&](Sprite sprite) {
+        StoreSpriteConfig(configCache, state, mainSprite);
+        // The sheet shown until now stays cached for flipping back to it
+        if (mainSprite.slicePaths.empty() && mainSprite.path != sprite.path)
+            StoreCachedSprite(renderer.textures, sheetCache, std::move(mainSprite));
+        else
+            UnloadManagedTexture(renderer.textures, mainSprite.tex);
+        browsedPath.clear();
+
+        state.configMode = true;
+        state.playAnimChecked = false;
+        state.pixelizerChecked = false;
+        state.tempHFramesValue = sprite.grid.hFrames;
+        state.tempVFramesValue = sprite.grid.vFrames;
+        state.layoutValue = (int)sprite.layout;
+        state.uiVisibilityChecked = true;
+        if (sprite.frameDuration > 0.0f) state.frameSpeedValue = std::min(std::max(sprite.frameDuration, 0.1f), 1.0f);
+
+        mainSprite = std::move(sprite);
+        if (mainSprite.tex.id != 0) spriteLoaded = true;
+        WatchFiles(watcher, GetSpriteFiles(mainSprite));
+        // Cached sprites may have been decoded before mipmaps or compression were toggled
+        bool optionsChanged = mainSprite.mipmaps != mipmapsRequested || mainSprite.compress != compressRequested;
+        if (mainSprite.tex.id != 0 && optionsChanged)
+            RequestSheetDecode(decoder, GetSpriteFiles(mainSprite), true, mipmapsRequested, compressRequested);
+
+        // Sheets opened before come back configured
+        SheetConfig config;
+        if (FindSheetConfig(configCache, HashString(mainSprite.path), mainSprite.contentHash, config)) {
+            ApplySheetConfig(state, config);
+            state.configMode = false;
+        }
+        UpdateSpriteFrames(mainSprite, GetSheetLayout(state));
+    };
+
+    // Decodes the browsed sheet when it is not shown or cached yet, then its neighbours, nearest
+    // first. Prefetches still queued for the previous position are dropped. Sessions decode the
+    // browsed sheet alone and drop nothing, as whether a prefetch was dropped before it started
+    // depends on timing and would make the replay take other sheets than the recording.
+    auto prefetchAround = [&]() {
+        int distance = sessionActive ? 0 : PREFETCH_DISTANCE;
+        if (!sessionActive) CancelSheetPrefetches(decoder);
+        for (int i = 0; i <= 2 * distance; i++) {
+            // 0, 1, -1, 2, -2...
+            int offset = (i + 1) / 2 * (i % 2 == 1 ? 1 : -1);
+            std::string path = GetBrowsedSheet(browser, offset);
+            if (path.empty() || path == mainSprite.path) continue;
+            if (sheetCache.sprites.count(path) == 0)
+                RequestSheetPrefetch(decoder, path, mipmapsRequested, compressRequested);
+        }
+    };
 
     while (!WindowShouldClose()) {
-        // File
+        // Recording logs the input and frame time of every frame, replaying feeds them back. Both
+        // see the measured time, so the logged hitches keep their length.
+        float frameTime = GetPacedFrameTime(pacer);
+        if (!UpdateInputSession(session, frameTime)) break;
+        // The step is clamped since the previous frame may have been idle
+        frameTime = std::min(frameTime, 0.1f);
+
+        // File, decoded on the worker and picked up once ready
         if (IsFileDropped()) {
-            state.configMode = true;
-            state.playAnimChecked = false;
-            state.pixelizerChecked = false;
-            state.tempHFramesValue = 1;
-            state.tempVFramesValue = 1;
-            state.uiVisibilityChecked = true;
+            FilePathList droppedFile = LoadDroppedFiles();
+            // Several files are the slices of one sheet, in file name order
+            std::vector<std::string> paths(droppedFile.paths, droppedFile.paths + droppedFile.count);
+            std::sort(paths.begin(), paths.end());
+            RequestSheetDecode(decoder, paths, false, mipmapsRequested, compressRequested);
+            UnloadDroppedFiles(droppedFile);
+        }
+
+        // Check if sprite has been modified, or if it needs its mipmaps or compression added or dropped
+        bool compress = state.compressChecked && compressionSupported;
+        bool optionsChanged =
+            spriteLoaded && (state.mipmapsChecked != mipmapsRequested || compress != compressRequested);
+        mipmapsRequested = state.mipmapsChecked;
+        compressRequested = compress;
+        if (ConsumeFileChange(watcher) || optionsChanged)
+            RequestSheetDecode(decoder, GetSpriteFiles(mainSprite), true, mipmapsRequested, compressRequested);
+
+        // Replays pick up sheets on the frames the recording did, waiting for the decoder if needed
+        int replayedSheets = GetReplayedSheetCount(session);
+        auto nextSheet = [&](DecodedSheet &sheet) {
+            if (session.mode != SessionMode::Replay) return PollDecodedSheet(decoder, sheet);
+            return replayedSheets-- > 0 && WaitDecodedSheet(decoder, sheet);
+        };
+
+        DecodedSheet sheet;
+        while (nextSheet(sheet)) {
+            RecordDecodedSheet(session);
+            if (sheet.prefetch) {
+                Sprite sprite = CreateSprite(renderer.textures, sheet);
+                if (sprite.path == browsedPath)
+                    showSprite(std::move(sprite));
+                else if (sprite.path != mainSprite.path)
+                    StoreCachedSprite(renderer.textures, sheetCache, std::move(sprite));
+                else
+                    UnloadManagedTexture(renderer.textures, sprite.tex);
+                continue;
+            }
+            if (sheet.reload) {
+                if (sheet.path != mainSprite.path) {
+                    UnloadImage(sheet.image);
+                    continue;
+                }
+                UpdateModifiedSprite(renderer.textures, mainSprite, sheet);
+                // Files storing their own grid, like Aseprite layers and frames, keep it in sync
+                if (sheet.grid.found) {
+                    state.tempHFramesValue = state.hFramesValue = sheet.grid.hFrames;
+                    state.tempVFramesValue = state.vFramesValue = sheet.grid.vFrames;
+                    state.layoutValue = (int)sheet.layout;
+                }
+                UnloadImage(sheet.image);
+                continue;
+            }
+
+            showSprite(CreateSprite(renderer.textures, sheet));
+            // A dropped sheet makes its folder the browsed one
+            if (mainSprite.slicePaths.empty())
+                BrowseFolderOf(browser, mainSprite.path);
+            else
+                ClearFolderBrowser(browser);
+            prefetchAround();
+        }
 
-            mainSprite = CreateSprite();
-            if (mainSprite.tex.id != 0) spriteLoaded = true;
-            UpdateSpriteFrames(mainSprite, state.hFramesValue, state.vFramesValue, 1.0f);
+        // Next and previous sheet of the folder, shown at once when it was prefetched
+        int browseStep = IsEditingValue(state) ? 0 : (int)IsKeyPressed(KEY_RIGHT) - (int)IsKeyPressed(KEY_LEFT);
+        std::string browsed = browseStep != 0 ? GetBrowsedSheet(browser, browseStep) : "";
+        if (!browsed.empty()) {
+            BrowseFolderOf(browser, browsed);
+            Sprite sprite;
+            if (TakeCachedSprite(renderer.textures, sheetCache, browsed, sprite))
+                showSprite(std::move(sprite));
+            else
+                browsedPath = browsed;
+            prefetchAround();
         }
 
+        // Profiler overlay and frame pacing
+        if (IsKeyPressed(KEY_F3)) profiler.visible = !profiler.visible;
+        if (IsKeyPressed(KEY_F4)) SetPacingMode(pacer, (PacingMode)(((int)pacer.mode + 1) % 3));
+
         // Show UI when it is hidden
         if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && !state.uiVisibilityChecked)
             state.uiVisibilityChecked = true;
 
-        // Check if sprite has been modified
-        if (mainSprite.modTime != GetFileModTime(mainSprite.path.c_str())) {
-            UpdateModifiedSprite(mainSprite);
-            mainSprite.modTime = GetFileModTime(mainSprite.path.c_str());
-        }
-
         // Update sprite frame size
         state.frameSize.x = mainSprite.texRec.width;
         state.frameSize.y = mainSprite.texRec.height;
 
         // Rotation
-        if (state.rotationChecked) mainSprite.rotation += GetFrameTime() * 20;
+        if (state.rotationChecked) mainSprite.rotation += frameTime * 20;
+
+        // Voxel view pitch or slice spacing
+        bool viewChanged = IsKeyDown(KEY_UP) || IsKeyDown(KEY_DOWN);
+        if (state.voxelChecked) {
+            if (IsKeyDown(KEY_UP)) state.voxelPitchValue += frameTime * 45;
+            if (IsKeyDown(KEY_DOWN)) state.voxelPitchValue -= frameTime * 45;
+            state.voxelPitchValue = std::min(std::max(state.voxelPitchValue, 0.0f), 90.0f);
+        } else {
+            if (IsKeyDown(KEY_UP)) state.spacingValue += frameTime;
+            if (IsKeyDown(KEY_DOWN)) state.spacingValue -= frameTime;
+            state.spacingValue = std::min(std::max(state.spacingValue, 0.0f), 4.0f);
+        }
+
+        // Zoom, each wheel step scales the target and the zoom eases towards it
+        float wheel = GetMouseWheelMove();
+        if (wheel != 0.0f) {
+            state.targetZoomValue = std::min(std::max(state.targetZoomValue * powf(1.25f, wheel), 0.125f), 32.0f);
+        }
+        if (state.zoomValue != state.targetZoomValue) {
+            state.zoomValue += (state.targetZoomValue - state.zoomValue) * (1.0f - expf(-frameTime * 12.0f));
+            if (fabsf(state.zoomValue - state.targetZoomValue) < 0.01f) state.zoomValue = state.targetZoomValue;
+            viewChanged = true;
+        }
 
         // Anim
-        frameCount++;
-        if (frameCount / (60 * state.frameSpeedValue) >= 1.0f && state.playAnimChecked) {
-            if (mainSprite.currentFrame < state.vFramesValue - 1)
+        animTime += frameTime;
+        if (animTime >= state.frameSpeedValue && state.playAnimChecked) {
+            if (mainSprite.currentFrame < GetSheetLayout(state).frames - 1)
                 ++mainSprite.currentFrame;
             else
                 mainSprite.currentFrame = 0;
 
-            frameCount = 0;
+            animTime = 0.0f;
         }
 
-        // Drawing
-        BeginTextureMode(target);
-        ClearBackground(state.backgroundColor);
-        // Stacked drawing
-        for (auto i = 0; i < mainSprite.drawRecs.size(); i++) {
-            mainSprite.texRec.x = (float)i * (float)mainSprite.tex.width / state.hFramesValue;
-            mainSprite.texRec.y = mainSprite.currentFrame * (float)mainSprite.tex.height / state.vFramesValue;
-            DrawTexturePro(mainSprite.tex, mainSprite.texRec, mainSprite.drawRecs[i], mainSprite.origin,
-                           mainSprite.rotation, WHITE);
+        // Drawing, the bake waits for the view to settle and the live stack is drawn meanwhile
+        if (state.bakeChecked && !state.playAnimChecked && !viewChanged && mainSprite.tex.id != 0 &&
+            !IsBakeCurrent(renderer.bake, state, mainSprite))
+            BakeSpriteRotations(renderer, state, mainSprite);
+
+        bool postEffect = state.pixelizerChecked;
+
+        if (postEffect) {
+            if (renderer.target.id == 0) renderer.target = LoadManagedRenderTexture(renderer.textures, WIDTH, HEIGHT);
+
+            BeginTextureMode(renderer.target);
+            ClearBackground(state.backgroundColor);
+            DrawPreviewStack(renderer, state, mainSprite);
+            EndTextureMode();
         }
-        EndTextureMode();
 
         BeginDrawing();
-        ClearBackground(state.backgroundColor);
 
         // Small texture preview
         // DrawTexture(mainSprite.tex, 15, 15, WHITE);
 
-        if (state.pixelizerChecked) {
-            BeginShaderMode(pixelShader);
-            DrawTextureRec(target.texture,
-                           Rectangle{0, 0, (float)target.texture.width, (float)-target.texture.height},
+        if (postEffect) {
+            // The pixelizer writes opaque pixels over the whole screen, no clear needed
+            BeginShaderMode(renderer.pixelShader);
+            DrawTextureRec(renderer.target.texture,
+                           Rectangle{0, 0, (float)renderer.target.texture.width,
+                                     (float)-renderer.target.texture.height},
                            Vector2{0, 0}, WHITE);
             EndShaderMode();
         } else {
-            DrawTextureRec(target.texture,
-                           Rectangle{0, 0, (float)target.texture.width, (float)-target.texture.height},
-                           Vector2{0, 0}, WHITE);
+            ClearBackground(state.backgroundColor);
+            DrawPreviewStack(renderer, state, mainSprite);
         }
 
         // GUI
@@ -266,18 +1444,56 @@ int main() {
             if (state.configMode) {
                 DrawConfigMode(state);
             } else {
-                DrawPreviewMode(state, mainSprite);
+                DrawPreviewMode(state, mainSprite, renderer);
             }
         }
 
-        UpdateSpriteFrames(mainSprite, state.hFramesValue, state.vFramesValue, 8.0f);
+        DrawProfilerOverlay(profiler, pacer, renderer.textures);
+
+        UpdateSpriteFrames(mainSprite, GetSheetLayout(state));
+
+        // Idle: nothing animates, so the next frame is only drawn after an input event or a
+        // file change wakes up the loop
+        bool idle = !state.rotationChecked && !state.playAnimChecked && !IsEditingValue(state) && !viewChanged &&
+                    session.mode != SessionMode::Replay;
+        if (idle != eventWaiting) {
+            if (idle)
+                EnableEventWaiting();
+            else
+                DisableEventWaiting();
+            eventWaiting = idle;
+        }
 
         EndDrawing();
+        EndFrame(pacer);
+
+        if (!profiler.startup.finished) {
+            FinishStartupProfile(profiler.startup);
+            LogStartupProfile(profiler.startup);
+            if (startupOnly) break;
+        }
+    }
+
+    StopInputSession(session);
+    StopFileWatcher(watcher);
+    StopDecodeWorker(decoder);
+
+    if (!sessionActive) {
+        StoreSpriteConfig(configCache, state, mainSprite);
+        SaveConfigCache(configCache);
     }
+    UnloadConfigCache(configCache);
 
-    UnloadTexture(mainSprite.tex);
-    UnloadShader(pixelShader);
-    UnloadRenderTexture(target);
+    LogTextureStats(renderer.textures);
+    UnloadManagedTexture(renderer.textures, mainSprite.tex);
+    UnloadSheetCache(renderer.textures, sheetCache);
+    UnloadShader(renderer.pixelShader);
+    UnloadStackBatch(renderer.stack.batch);
+    UnloadManagedRenderTexture(renderer.textures, renderer.target);
+    UnloadRotationBake(renderer.textures, renderer.bake);
+    UnloadVoxelView(renderer.textures, renderer.voxels);
+    UnloadTextureManager(renderer.textures);
+    UnloadFont(ubuFont);
 
     CloseWindow();
 
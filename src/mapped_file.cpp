@@ -0,0 +1,74 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool MapFile(MappedFile &file, const std::string &path) {
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (mapping == nullptr) return false;
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file.data = static_cast<const unsigned char *>(data);
+    file.size = (size_t)size.QuadPart;
+    file.handle = mapping;
+    return true;
+}
+
+void UnmapFile(MappedFile &file) {
+    if (file.data != nullptr) UnmapViewOfFile(file.data);
+    if (file.handle != nullptr) CloseHandle(file.handle);
+    file = MappedFile{};
+}
+
+#else
+
+bool MapFile(MappedFile &file, const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file.data = static_cast<const unsigned char *>(data);
+    file.size = (size_t)info.st_size;
+    return true;
+}
+
+void UnmapFile(MappedFile &file) {
+    if (file.data != nullptr) munmap(const_cast<unsigned char *>(file.data), file.size);
+    file = MappedFile{};
+}
+
+#endif
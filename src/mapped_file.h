@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file
+struct MappedFile {
+    const unsigned char *data{nullptr};
+    size_t size{0};
+    void *handle{nullptr};
+};
+
+bool MapFile(MappedFile &file, const std::string &path);
+void UnmapFile(MappedFile &file);
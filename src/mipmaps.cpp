@@ -0,0 +1,87 @@
+#include "mipmaps.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+static void DownsampleLevel(const uint8_t *src, int srcWidth, int srcHeight, uint8_t *dst, int dstWidth,
+                            int dstHeight) {
+    for (int y = 0; y < dstHeight; y++) {
+        // Odd sizes repeat the last row or column instead of reading past it
+        const uint8_t *rows[2] = {src + (size_t)std::min(2 * y, srcHeight - 1) * srcWidth * 4,
+                                  src + (size_t)std::min(2 * y + 1, srcHeight - 1) * srcWidth * 4};
+        uint8_t *out = dst + (size_t)y * dstWidth * 4;
+
+        for (int x = 0; x < dstWidth; x++) {
+            int columns[2] = {std::min(2 * x, srcWidth - 1) * 4, std::min(2 * x + 1, srcWidth - 1) * 4};
+            uint32_t r = 0, g = 0, b = 0, a = 0;
+            for (const uint8_t *row : rows) {
+                for (int column : columns) {
+                    const uint8_t *texel = row + column;
+                    r += texel[0] * texel[3];
+                    g += texel[1] * texel[3];
+                    b += texel[2] * texel[3];
+                    a += texel[3];
+                }
+            }
+
+            if (a == 0) {
+                out[0] = out[1] = out[2] = out[3] = 0;
+            } else {
+                out[0] = (uint8_t)((r + a / 2) / a);
+                out[1] = (uint8_t)((g + a / 2) / a);
+                out[2] = (uint8_t)((b + a / 2) / a);
+                out[3] = (uint8_t)((a + 2) / 4);
+            }
+            out += 4;
+        }
+    }
+}
+
+void GenImageBoxMipmaps(Image &image) {
+    if (image.data == nullptr || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || image.mipmaps > 1) return;
+
+    int levels = 1;
+    size_t size = (size_t)image.width * image.height * 4;
+    for (int width = image.width, height = image.height; width > 1 || height > 1; levels++) {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        size += (size_t)width * height * 4;
+    }
+
+    uint8_t *data = static_cast<uint8_t *>(MemRealloc(image.data, (unsigned int)size));
+    if (data == nullptr) return;
+    image.data = data;
+
+    uint8_t *level = data;
+    int width = image.width;
+    int height = image.height;
+    for (int i = 1; i < levels; i++) {
+        int nextWidth = std::max(width / 2, 1);
+        int nextHeight = std::max(height / 2, 1);
+        uint8_t *next = level + (size_t)width * height * 4;
+        DownsampleLevel(level, width, height, next, nextWidth, nextHeight);
+
+        level = next;
+        width = nextWidth;
+        height = nextHeight;
+    }
+    image.mipmaps = levels;
+}
+
+int GetGridMipLevels(int cellWidth, int cellHeight, int mipmaps) {
+    int level = 0;
+    while (level + 1 < mipmaps && cellWidth % 2 == 0 && cellHeight % 2 == 0) {
+        cellWidth /= 2;
+        cellHeight /= 2;
+        level++;
+    }
+    return level;
+}
+
+size_t GetTextureMemorySize(Texture2D tex) {
+    size_t size = 0;
+    for (int level = 0; level < std::max(tex.mipmaps, 1); level++)
+        size += GetPixelDataSize(std::max(tex.width >> level, 1), std::max(tex.height >> level, 1), tex.format);
+    return size;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+#include "raylib.h"
+
+// Appends the full mip chain of a RGBA8 image, down to 1x1, with the sizes raylib expects on
+// upload. Every texel is the 2x2 box average of the level above, weighted by alpha so the
+// transparent pixels around slices don't darken their edges. Other formats are left as they are.
+void GenImageBoxMipmaps(Image &image);
+// Deepest level whose texels never mix two cells of a grid with the given cell size
+int GetGridMipLevels(int cellWidth, int cellHeight, int mipmaps);
+// GPU memory of a texture along with its mip chain
+size_t GetTextureMemorySize(Texture2D tex);
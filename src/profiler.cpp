@@ -0,0 +1,58 @@
+#include "profiler.h"
+
+#include "raylib.h"
+
+static double MillisecondsBetween(std::chrono::steady_clock::time_point from,
+                                  std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+void BeginStartupProfile(StartupProfile &profile) {
+    profile = StartupProfile{};
+    profile.start = profile.last = std::chrono::steady_clock::now();
+}
+
+void MarkStartupStage(StartupProfile &profile, const char *name) {
+    if (profile.finished) return;
+    auto now = std::chrono::steady_clock::now();
+    profile.stages.push_back({name, MillisecondsBetween(profile.last, now), false});
+    profile.last = now;
+}
+
+void AddBackgroundStage(StartupProfile &profile, const char *name, double milliseconds) {
+    if (profile.finished) return;
+    profile.stages.push_back({name, milliseconds, true});
+}
+
+void FinishStartupProfile(StartupProfile &profile) {
+    if (profile.finished) return;
+    MarkStartupStage(profile, "first frame");
+    profile.firstFrame = MillisecondsBetween(profile.start, profile.last);
+    profile.finished = true;
+}
+
+void LogStartupProfile(const StartupProfile &profile) {
+    for (const StartupStage &stage : profile.stages) {
+        TraceLog(LOG_INFO, "STARTUP: %-24s %8.2f ms%s", stage.name.c_str(), stage.milliseconds,
+                 stage.background ? " (background)" : "");
+    }
+    TraceLog(LOG_INFO, "STARTUP: %-24s %8.2f ms", "time to first frame", profile.firstFrame);
+}
+
+void DrawProfilerOverlay(const Profiler &profiler, const FramePacer &pacer, const TextureManager &textures) {
+    if (!profiler.visible) return;
+
+    double frameTime = pacer.frameTime > 0.0 ? pacer.frameTime : pacer.refreshPeriod;
+
+    DrawRectangle(5, 5, 190, 119, Fade(BLACK, 0.6f));
+    DrawText(TextFormat("Pacing: %s", GetPacingModeName(pacer.mode)), 10, 10, 10, WHITE);
+    DrawText(TextFormat("Frame: %.2f ms (%d FPS)", frameTime * 1000.0, (int)(1.0 / frameTime)), 10, 25, 10,
+             WHITE);
+    DrawText(TextFormat("Work: %.2f ms", pacer.workTime * 1000.0), 10, 40, 10, WHITE);
+    DrawText(TextFormat("Input to present: %.2f ms", pacer.latency * 1000.0), 10, 55, 10, WHITE);
+    DrawText(TextFormat("Startup: %.1f ms to first frame", profiler.startup.firstFrame), 10, 70, 10, WHITE);
+    DrawText(TextFormat("Textures: %d, %.1f of %d MB", (int)textures.textures.size(), textures.bytes / 1048576.0,
+                        (int)(textures.budget >> 20)),
+             10, 85, 10, WHITE);
+    DrawText(TextFormat("Reused %d, evicted %d", textures.stats.reuses, textures.stats.evictions), 10, 100, 10, WHITE);
+}
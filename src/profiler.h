@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "frame_pacer.h"
+#include "texture_manager.h"
+
+struct StartupStage {
+    std::string name;
+    double milliseconds;
+    // Ran on another thread, overlapping the stages of the main thread
+    bool background;
+};
+
+// Wall-clock cost of every stage of startup, from main to the first presented frame
+struct StartupProfile {
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last;
+    std::vector<StartupStage> stages;
+    double firstFrame{0.0};
+    bool finished{false};
+};
+
+struct Profiler {
+    bool visible{false};
+    StartupProfile startup;
+};
+
+void BeginStartupProfile(StartupProfile &profile);
+// Records the time since the previous mark, or since the beginning
+void MarkStartupStage(StartupProfile &profile, const char *name);
+void AddBackgroundStage(StartupProfile &profile, const char *name, double milliseconds);
+// Called once the first frame is presented, the next calls do nothing
+void FinishStartupProfile(StartupProfile &profile);
+void LogStartupProfile(const StartupProfile &profile);
+
+void DrawProfilerOverlay(const Profiler &profiler, const FramePacer &pacer, const TextureManager &textures);
@@ -0,0 +1,85 @@
+#include "qoi_writer.h"
+
+#include <cstring>
+
+const uint8_t QOI_OP_INDEX = 0x00;
+const uint8_t QOI_OP_DIFF = 0x40;
+const uint8_t QOI_OP_LUMA = 0x80;
+const uint8_t QOI_OP_RUN = 0xC0;
+const uint8_t QOI_OP_RGB = 0xFE;
+const uint8_t QOI_OP_RGBA = 0xFF;
+const int QOI_MAX_RUN = 62;
+const uint8_t QOI_END_MARKER[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+static void WriteBigEndian(std::ofstream &file, uint32_t value) {
+    const char bytes[4] = {(char)(value >> 24), (char)(value >> 16), (char)(value >> 8), (char)value};
+    file.write(bytes, 4);
+}
+
+static void FlushRun(QoiWriter &writer) {
+    if (writer.run == 0) return;
+    writer.file.put((char)(QOI_OP_RUN | (writer.run - 1)));
+    writer.run = 0;
+}
+
+bool OpenQoiWriter(QoiWriter &writer, const std::string &path, uint32_t width, uint32_t height) {
+    writer.file.open(path, std::ios::binary | std::ios::trunc);
+    writer.width = width;
+    writer.height = height;
+    writer.pixelsLeft = (uint64_t)width * height;
+    if (!writer.file) return false;
+
+    writer.file.write("qoif", 4);
+    WriteBigEndian(writer.file, width);
+    WriteBigEndian(writer.file, height);
+    // Four channels, sRGB with linear alpha
+    writer.file.put(4);
+    writer.file.put(0);
+    return (bool)writer.file;
+}
+
+void WriteQoiPixels(QoiWriter &writer, const uint8_t *pixels, size_t count) {
+    if (count > writer.pixelsLeft) count = (size_t)writer.pixelsLeft;
+    writer.pixelsLeft -= count;
+
+    for (size_t i = 0; i < count; i++, pixels += 4) {
+        if (std::memcmp(pixels, writer.previous, 4) == 0) {
+            if (++writer.run == QOI_MAX_RUN) FlushRun(writer);
+            continue;
+        }
+        FlushRun(writer);
+
+        int hash = (pixels[0] * 3 + pixels[1] * 5 + pixels[2] * 7 + pixels[3] * 11) % 64;
+        if (std::memcmp(writer.index[hash], pixels, 4) == 0) {
+            writer.file.put((char)(QOI_OP_INDEX | hash));
+        } else if (pixels[3] == writer.previous[3]) {
+            // Channel differences wrap around like the decoder's additions
+            int dr = (int8_t)(pixels[0] - writer.previous[0]);
+            int dg = (int8_t)(pixels[1] - writer.previous[1]);
+            int db = (int8_t)(pixels[2] - writer.previous[2]);
+            int drDg = dr - dg, dbDg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                writer.file.put((char)(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            } else if (dg >= -32 && dg <= 31 && drDg >= -8 && drDg <= 7 && dbDg >= -8 && dbDg <= 7) {
+                writer.file.put((char)(QOI_OP_LUMA | (dg + 32)));
+                writer.file.put((char)((drDg + 8) << 4 | (dbDg + 8)));
+            } else {
+                writer.file.put((char)QOI_OP_RGB);
+                writer.file.write(reinterpret_cast<const char *>(pixels), 3);
+            }
+        } else {
+            writer.file.put((char)QOI_OP_RGBA);
+            writer.file.write(reinterpret_cast<const char *>(pixels), 4);
+        }
+        std::memcpy(writer.index[hash], pixels, 4);
+        std::memcpy(writer.previous, pixels, 4);
+    }
+}
+
+bool CloseQoiWriter(QoiWriter &writer) {
+    FlushRun(writer);
+    writer.file.write(reinterpret_cast<const char *>(QOI_END_MARKER), sizeof(QOI_END_MARKER));
+    bool complete = writer.pixelsLeft == 0 && (bool)writer.file;
+    writer.file.close();
+    return complete;
+}
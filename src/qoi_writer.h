@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// QOI image written a band of rows at a time, so images larger than memory can be produced.
+// The encoder state carries over between bands, the file is the same as a single write.
+struct QoiWriter {
+    std::ofstream file;
+    uint32_t width{0};
+    uint32_t height{0};
+    uint64_t pixelsLeft{0};
+    uint8_t index[64][4]{};
+    uint8_t previous[4]{0, 0, 0, 255};
+    int run{0};
+};
+
+bool OpenQoiWriter(QoiWriter &writer, const std::string &path, uint32_t width, uint32_t height);
+// RGBA8 pixels, whole rows in top to bottom order
+void WriteQoiPixels(QoiWriter &writer, const uint8_t *pixels, size_t count);
+// False when fewer pixels than the image holds were written or the file could not be written
+bool CloseQoiWriter(QoiWriter &writer);
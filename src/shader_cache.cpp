@@ -0,0 +1,241 @@
+#include "shader_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "hash.h"
+#include "rlgl.h"
+
+const char SHADER_CACHE_MAGIC[4] = {'M', 'S', 'S', 'B'};
+const uint32_t SHADER_CACHE_VERSION = 1;
+
+const unsigned int GL_ENUM_VENDOR = 0x1F00;
+const unsigned int GL_ENUM_RENDERER = 0x1F01;
+const unsigned int GL_ENUM_VERSION = 0x1F02;
+const unsigned int GL_ENUM_LINK_STATUS = 0x8B82;
+const unsigned int GL_ENUM_PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+const unsigned int GL_ENUM_PROGRAM_BINARY_LENGTH = 0x8741;
+const unsigned int GL_ENUM_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+// rlgl links programs without asking for a retrievable binary and doesn't expose the binary
+// calls, so programs are linked here
+struct GlProgramProcs {
+    unsigned int (*createProgram)(void);
+    void (*attachShader)(unsigned int program, unsigned int shader);
+    void (*detachShader)(unsigned int program, unsigned int shader);
+    void (*deleteShader)(unsigned int shader);
+    void (*bindAttribLocation)(unsigned int program, unsigned int index, const char *name);
+    void (*programParameteri)(unsigned int program, unsigned int name, int value);
+    void (*linkProgram)(unsigned int program);
+    void (*getProgramiv)(unsigned int program, unsigned int name, int *value);
+    void (*getProgramBinary)(unsigned int program, int size, int *length, unsigned int *format, void *binary);
+    void (*programBinary)(unsigned int program, unsigned int format, const void *binary, int length);
+    const unsigned char *(*getString)(unsigned int name);
+    void (*getIntegerv)(unsigned int name, int *value);
+};
+
+static GlProgramProcs gl{};
+
+struct AttribBinding {
+    unsigned int index;
+    const char *name;
+};
+
+// The attribute locations rlgl binds before linking
+static const AttribBinding ATTRIB_BINDINGS[] = {
+    {RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION},
+    {RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD},
+    {RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL},
+    {RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR},
+    {RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT},
+    {RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2},
+};
+
+struct ShaderBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+};
+
+template <typename Proc> static bool LoadProc(Proc &proc, const char *name) {
+    proc = (Proc)glfwGetProcAddress(name);
+    return proc != nullptr;
+}
+
+void InitShaderCache(ShaderCache &cache, const std::string &directory) {
+    cache = ShaderCache{};
+    cache.directory = directory;
+
+    bool loaded = LoadProc(gl.createProgram, "glCreateProgram") &&
+                  LoadProc(gl.attachShader, "glAttachShader") && LoadProc(gl.detachShader, "glDetachShader") &&
+                  LoadProc(gl.deleteShader, "glDeleteShader") &&
+                  LoadProc(gl.bindAttribLocation, "glBindAttribLocation") &&
+                  LoadProc(gl.programParameteri, "glProgramParameteri") &&
+                  LoadProc(gl.linkProgram, "glLinkProgram") && LoadProc(gl.getProgramiv, "glGetProgramiv") &&
+                  LoadProc(gl.getProgramBinary, "glGetProgramBinary") &&
+                  LoadProc(gl.programBinary, "glProgramBinary") && LoadProc(gl.getString, "glGetString") &&
+                  LoadProc(gl.getIntegerv, "glGetIntegerv");
+    if (!loaded) return;
+
+    int formats = 0;
+    gl.getIntegerv(GL_ENUM_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    cache.supported = formats > 0;
+
+    // Binaries only load on the driver that produced them
+    for (unsigned int name : {GL_ENUM_VENDOR, GL_ENUM_RENDERER, GL_ENUM_VERSION}) {
+        const char *text = reinterpret_cast<const char *>(gl.getString(name));
+        if (text != nullptr) cache.driverHash = HashBytes(text, std::strlen(text) + 1, cache.driverHash);
+    }
+}
+
+static uint64_t GetShaderKey(const ShaderCache &cache, const char *vsCode, const char *fsCode) {
+    // The terminating zeros keep the two sources apart
+    uint64_t key = HashBytes(vsCode, std::strlen(vsCode) + 1, cache.driverHash);
+    return HashBytes(fsCode, std::strlen(fsCode) + 1, key);
+}
+
+static bool IsLinked(unsigned int program) {
+    int status = 0;
+    gl.getProgramiv(program, GL_ENUM_LINK_STATUS, &status);
+    return status != 0;
+}
+
+// Same locations LoadShaderFromMemory looks up, so raylib draws with the shader as usual and
+// UnloadShader releases it
+static Shader MakeShader(unsigned int program) {
+    Shader shader{program, static_cast<int *>(MemAlloc(RL_MAX_SHADER_LOCATIONS * sizeof(int)))};
+    for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) shader.locs[i] = -1;
+
+    auto attrib = [program](const char *name) { return rlGetLocationAttrib(program, name); };
+    auto uniform = [program](const char *name) { return rlGetLocationUniform(program, name); };
+    shader.locs[SHADER_LOC_VERTEX_POSITION] = attrib(RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = attrib(RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] = attrib(RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+    shader.locs[SHADER_LOC_VERTEX_NORMAL] = attrib(RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+    shader.locs[SHADER_LOC_VERTEX_TANGENT] = attrib(RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+    shader.locs[SHADER_LOC_VERTEX_COLOR] = attrib(RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+    shader.locs[SHADER_LOC_MATRIX_MVP] = uniform(RL_DEFAULT_SHADER_UNIFORM_NAME_MVP);
+    shader.locs[SHADER_LOC_MATRIX_VIEW] = uniform(RL_DEFAULT_SHADER_UNIFORM_NAME_VIEW);
+    shader.locs[SHADER_LOC_MATRIX_PROJECTION] = uniform(RL_DEFAULT_SHADER_UNIFORM_NAME_PROJECTION);
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = uniform(RL_DEFAULT_SHADER_UNIFORM_NAME_MODEL);
+    shader.locs[SHADER_LOC_MATRIX_NORMAL] = uniform(RL_DEFAULT_SHADER_UNIFORM_NAME_NORMAL);
+    shader.locs[SHADER_LOC_COLOR_DIFFUSE] = uniform(RL_DEFAULT_SHADER_UNIFORM_NAME_COLOR);
+    shader.locs[SHADER_LOC_MAP_DIFFUSE] = uniform(RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE0);
+    shader.locs[SHADER_LOC_MAP_SPECULAR] = uniform(RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE1);
+    shader.locs[SHADER_LOC_MAP_NORMAL] = uniform(RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE2);
+    return shader;
+}
+
+// Compiles with rlgl and links like rlgl does, but asks the driver to keep the binary
+// retrievable
+static unsigned int LinkProgram(const char *vsCode, const char *fsCode) {
+    unsigned int vertex = rlCompileShader(vsCode, RL_VERTEX_SHADER);
+    unsigned int fragment = rlCompileShader(fsCode, RL_FRAGMENT_SHADER);
+
+    unsigned int program = 0;
+    if (vertex != 0 && fragment != 0) {
+        program = gl.createProgram();
+        gl.attachShader(program, vertex);
+        gl.attachShader(program, fragment);
+        for (const AttribBinding &binding : ATTRIB_BINDINGS)
+            gl.bindAttribLocation(program, binding.index, binding.name);
+        gl.programParameteri(program, GL_ENUM_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+        gl.linkProgram(program);
+        gl.detachShader(program, vertex);
+        gl.detachShader(program, fragment);
+
+        if (!IsLinked(program)) {
+            rlUnloadShaderProgram(program);
+            program = 0;
+        }
+    }
+
+    if (vertex != 0) gl.deleteShader(vertex);
+    if (fragment != 0) gl.deleteShader(fragment);
+    return program;
+}
+
+static std::string GetBinaryPath(const ShaderCache &cache, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::path(cache.directory) / name).string();
+}
+
+static unsigned int LoadProgramBinary(const std::string &path, uint64_t key) {
+    std::ifstream file(path, std::ios::binary);
+    ShaderBinaryHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) return 0;
+    if (std::memcmp(header.magic, SHADER_CACHE_MAGIC, 4) != 0 || header.version != SHADER_CACHE_VERSION ||
+        header.key != key)
+        return 0;
+
+    std::vector<char> binary(header.size);
+    if (!file.read(binary.data(), binary.size())) return 0;
+
+    unsigned int program = gl.createProgram();
+    gl.programBinary(program, header.format, binary.data(), (int)binary.size());
+    if (IsLinked(program)) return program;
+
+    rlUnloadShaderProgram(program);
+    return 0;
+}
+
+static void SaveProgramBinary(const ShaderCache &cache, const std::string &path, uint64_t key,
+                              unsigned int program) {
+    int size = 0;
+    gl.getProgramiv(program, GL_ENUM_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) return;
+
+    ShaderBinaryHeader header{};
+    std::memcpy(header.magic, SHADER_CACHE_MAGIC, 4);
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+
+    std::vector<char> binary(size);
+    int written = 0;
+    gl.getProgramBinary(program, size, &written, &header.format, binary.data());
+    if (written <= 0) return;
+    header.size = (uint32_t)written;
+
+    std::error_code error;
+    std::filesystem::create_directories(cache.directory, error);
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) return;
+    }
+    std::filesystem::rename(tempPath, path, error);
+}
+
+Shader LoadCachedShader(ShaderCache &cache, const char *vsCode, const char *fsCode) {
+    if (!cache.supported || vsCode == nullptr || fsCode == nullptr)
+        return LoadShaderFromMemory(vsCode, fsCode);
+
+    uint64_t key = GetShaderKey(cache, vsCode, fsCode);
+    std::string path = GetBinaryPath(cache, key);
+
+    unsigned int program = LoadProgramBinary(path, key);
+    if (program != 0) {
+        cache.hits++;
+        return MakeShader(program);
+    }
+
+    cache.misses++;
+    program = LinkProgram(vsCode, fsCode);
+    // raylib reports the errors and falls back to its default shader
+    if (program == 0) return LoadShaderFromMemory(vsCode, fsCode);
+
+    SaveProgramBinary(cache, path, key, program);
+    return MakeShader(program);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "raylib.h"
+
+// Linked program binaries kept on disk, keyed by the shader sources and the GL driver. A
+// binary the driver rejects is compiled again and replaced.
+struct ShaderCache {
+    std::string directory;
+    uint64_t driverHash{0};
+    // The driver hands out and takes back program binaries
+    bool supported{false};
+    int hits{0};
+    int misses{0};
+};
+
+// Needs the GL context
+void InitShaderCache(ShaderCache &cache, const std::string &directory);
+// Same result as LoadShaderFromMemory, but both stages are required
+Shader LoadCachedShader(ShaderCache &cache, const char *vsCode, const char *fsCode);
@@ -0,0 +1,89 @@
+#include "sheet_layout.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+SheetLayout MakeSheetLayout(LayoutOrder order, int columns, int rows) {
+    SheetLayout layout;
+    layout.order = order;
+    layout.columns = std::max(columns, 1);
+    switch (order) {
+    case LayoutOrder::RowMajor:
+        layout.slices = std::max(columns, 1);
+        layout.frames = std::max(rows, 1);
+        break;
+    case LayoutOrder::ColumnMajor:
+        layout.slices = std::max(rows, 1);
+        layout.frames = std::max(columns, 1);
+        break;
+    case LayoutOrder::SliceGrid:
+        layout.slices = std::max(columns, 1) * std::max(rows, 1);
+        layout.frames = 1;
+        break;
+    }
+    return layout;
+}
+
+int GetLayoutColumns(const SheetLayout &layout) {
+    return layout.columns;
+}
+
+int GetLayoutRows(const SheetLayout &layout) {
+    switch (layout.order) {
+    case LayoutOrder::RowMajor:
+        return layout.frames;
+    case LayoutOrder::ColumnMajor:
+        return layout.slices;
+    case LayoutOrder::SliceGrid:
+        return (layout.slices + layout.columns - 1) / layout.columns;
+    }
+    return 1;
+}
+
+Vector2 GetLayoutCellSize(const SheetLayout &layout, int sheetWidth, int sheetHeight) {
+    return Vector2{(float)(sheetWidth / GetLayoutColumns(layout)), (float)(sheetHeight / GetLayoutRows(layout))};
+}
+
+Rectangle GetLayoutCell(const SheetLayout &layout, Vector2 cellSize, int slice, int frame) {
+    // Sheets are flipped vertically when loaded, slices running down the sheet are counted from
+    // the last row so the first slice is the top one of the file in every layout
+    int column = slice;
+    int row = frame;
+    if (layout.order == LayoutOrder::ColumnMajor) {
+        column = frame;
+        row = GetLayoutRows(layout) - 1 - slice;
+    } else if (layout.order == LayoutOrder::SliceGrid) {
+        column = slice % layout.columns;
+        row = GetLayoutRows(layout) - 1 - slice / layout.columns;
+    }
+    return Rectangle{column * cellSize.x, row * cellSize.y, cellSize.x, cellSize.y};
+}
+
+Image PackSliceImages(const std::vector<Image> &slices) {
+    int cellWidth = 0;
+    int cellHeight = 0;
+    for (const Image &slice : slices) {
+        cellWidth = std::max(cellWidth, slice.width);
+        cellHeight = std::max(cellHeight, slice.height);
+    }
+
+    Image sheet = GenImageColor(cellWidth * (int)slices.size(), cellHeight, BLANK);
+    if (sheet.data == nullptr) return sheet;
+
+    uint32_t *pixels = static_cast<uint32_t *>(sheet.data);
+    for (size_t i = 0; i < slices.size(); i++) {
+        const Image &slice = slices[i];
+        if (slice.data == nullptr || slice.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) continue;
+
+        int left = (int)i * cellWidth + (cellWidth - slice.width) / 2;
+        int top = (cellHeight - slice.height) / 2;
+        const uint32_t *source = static_cast<const uint32_t *>(slice.data);
+        for (int y = 0; y < slice.height; y++) {
+            std::memcpy(pixels + (size_t)(top + y) * sheet.width + left, source + (size_t)y * slice.width,
+                        (size_t)slice.width * 4);
+        }
+    }
+    return sheet;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+
+// Direction the slices run on a sheet, the animation frames run the other way. A slice grid
+// has a single frame whose slices fill the rows one after the other, for stacks too tall to
+// fit in one row of a texture.
+enum class LayoutOrder { RowMajor, ColumnMajor, SliceGrid };
+
+// Maps (slice, frame) to a cell of the sheet. Slices exported as separate files are packed
+// into one row-major sheet when loaded, so every layout is drawn from a single texture.
+struct SheetLayout {
+    LayoutOrder order{LayoutOrder::RowMajor};
+    int slices{1};
+    int frames{1};
+    int columns{1};
+};
+
+inline bool operator==(const SheetLayout &a, const SheetLayout &b) {
+    return a.order == b.order && a.slices == b.slices && a.frames == b.frames && a.columns == b.columns;
+}
+inline bool operator!=(const SheetLayout &a, const SheetLayout &b) { return !(a == b); }
+
+// From the number of grid columns and rows of the sheet
+SheetLayout MakeSheetLayout(LayoutOrder order, int columns, int rows);
+int GetLayoutColumns(const SheetLayout &layout);
+int GetLayoutRows(const SheetLayout &layout);
+// Cells are whole pixels, a remainder at the right or bottom edge of the sheet is unused
+Vector2 GetLayoutCellSize(const SheetLayout &layout, int sheetWidth, int sheetHeight);
+Rectangle GetLayoutCell(const SheetLayout &layout, Vector2 cellSize, int slice, int frame);
+
+// Puts one image per slice side by side, each centred in a cell as large as the largest one.
+// The images must be RGBA8, the result is a row-major sheet.
+Image PackSliceImages(const std::vector<Image> &slices);
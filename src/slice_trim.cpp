@@ -0,0 +1,88 @@
+#include "slice_trim.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static int LowestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+static int HighestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+AlphaMask BuildAlphaMask(const Image &image) {
+    AlphaMask mask;
+    if (image.data == nullptr || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return mask;
+
+    mask.width = image.width;
+    mask.height = image.height;
+    mask.stride = (image.width + 63) / 64;
+    mask.bits.assign((size_t)mask.stride * mask.height, 0);
+
+    const uint32_t *pixels = static_cast<const uint32_t *>(image.data);
+    for (int y = 0; y < image.height; y++) {
+        const uint32_t *row = pixels + (size_t)y * image.width;
+        uint64_t *bits = mask.bits.data() + (size_t)y * mask.stride;
+        for (int x = 0; x < image.width; x++) {
+            if (row[x] >> 24) bits[x >> 6] |= 1ull << (x & 63);
+        }
+    }
+
+    return mask;
+}
+
+Rectangle GetOpaqueBounds(const AlphaMask &mask, Rectangle rec) {
+    if (mask.bits.empty()) return rec;
+
+    int x0 = (int)rec.x;
+    int y0 = (int)rec.y;
+    int x1 = x0 + (int)rec.width;
+    int y1 = y0 + (int)rec.height;
+    if (x0 < 0 || y0 < 0 || x1 > mask.width || y1 > mask.height || x0 >= x1 || y0 >= y1) return rec;
+
+    int minX = x1, maxX = x0 - 1, minY = y1, maxY = y0 - 1;
+    int firstWord = x0 >> 6;
+    int lastWord = (x1 - 1) >> 6;
+    uint64_t firstMask = ~0ull << (x0 & 63);
+    uint64_t lastMask = ~0ull >> (63 - ((x1 - 1) & 63));
+
+    for (int y = y0; y < y1; y++) {
+        const uint64_t *row = mask.bits.data() + (size_t)y * mask.stride;
+        bool visible = false;
+
+        for (int w = firstWord; w <= lastWord; w++) {
+            uint64_t word = row[w];
+            if (w == firstWord) word &= firstMask;
+            if (w == lastWord) word &= lastMask;
+            if (word == 0) continue;
+
+            visible = true;
+            int low = (w << 6) + LowestBit(word);
+            int high = (w << 6) + HighestBit(word);
+            if (low < minX) minX = low;
+            if (high > maxX) maxX = high;
+        }
+
+        if (visible) {
+            if (y < minY) minY = y;
+            maxY = y;
+        }
+    }
+
+    if (maxY < minY) return Rectangle{rec.x, rec.y, 0.0f, 0.0f};
+    return Rectangle{(float)minX, (float)minY, (float)(maxX - minX + 1), (float)(maxY - minY + 1)};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+
+// One bit per pixel telling whether it is visible (alpha > 0)
+struct AlphaMask {
+    int width{0};
+    int height{0};
+    int stride{0};
+    std::vector<uint64_t> bits;
+};
+
+// Only RGBA8 images get a mask, without one nothing is trimmed
+AlphaMask BuildAlphaMask(const Image &image);
+// Smallest rectangle inside rec holding every visible pixel, zero sized when there is none
+Rectangle GetOpaqueBounds(const AlphaMask &mask, Rectangle rec);
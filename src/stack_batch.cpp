@@ -0,0 +1,114 @@
+#include "stack_batch.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "assets.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+// Two triangles covering the unit square
+static const float QUAD_VERTICES[12] = {0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0};
+
+static void SetUniform(const Shader &shader, const char *name, const void *value, int type) {
+    rlSetUniform(rlGetLocationUniform(shader.id, name), value, type, 1);
+}
+
+void LoadStackBatch(StackBatch &batch, ShaderCache &shaders) {
+    batch.shader = LoadCachedShader(shaders, GetAssetText(stack_vert), GetAssetText(stack_frag));
+
+    batch.vao = rlLoadVertexArray();
+    rlEnableVertexArray(batch.vao);
+    batch.quadBuffer = rlLoadVertexBuffer(QUAD_VERTICES, sizeof(QUAD_VERTICES), false);
+    rlSetVertexAttribute(0, 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(0);
+    rlDisableVertexArray();
+}
+
+void UnloadStackBatch(StackBatch &batch) {
+    if (batch.instanceBuffer != 0) rlUnloadVertexBuffer(batch.instanceBuffer);
+    if (batch.cellBuffer != 0) rlUnloadVertexBuffer(batch.cellBuffer);
+    if (batch.quadBuffer != 0) rlUnloadVertexBuffer(batch.quadBuffer);
+    if (batch.vao != 0) rlUnloadVertexArray(batch.vao);
+    if (batch.shader.id != 0) UnloadShader(batch.shader);
+    batch = StackBatch{};
+}
+
+// Replaces the per-instance buffer bound to the attribute with one holding the data
+static unsigned int LoadInstanceBuffer(unsigned int buffer, int attribute, int components, const void *data,
+                                       int size) {
+    if (buffer != 0) rlUnloadVertexBuffer(buffer);
+    buffer = rlLoadVertexBuffer(data, size, true);
+    rlSetVertexAttribute(attribute, components, RL_FLOAT, false, 0, 0);
+    rlSetVertexAttributeDivisor(attribute, 1);
+    rlEnableVertexAttribute(attribute);
+    return buffer;
+}
+
+void UpdateStackBatch(StackBatch &batch, const Rectangle *trims, const Vector2 *cells, int count, bool reversed) {
+    if (batch.vao == 0) return;
+
+    std::vector<Rectangle> instances(trims, trims + count);
+    std::vector<Vector2> origins(cells, cells + count);
+    if (reversed) {
+        std::reverse(instances.begin(), instances.end());
+        std::reverse(origins.begin(), origins.end());
+    }
+    int trimSize = count * (int)sizeof(Rectangle);
+    int originSize = count * (int)sizeof(Vector2);
+
+    // The buffers only grow, the slice count rarely changes
+    if (count > batch.capacity) {
+        rlEnableVertexArray(batch.vao);
+        batch.instanceBuffer = LoadInstanceBuffer(batch.instanceBuffer, 1, 4, instances.data(), trimSize);
+        batch.cellBuffer = LoadInstanceBuffer(batch.cellBuffer, 2, 2, origins.data(), originSize);
+        rlDisableVertexArray();
+        batch.capacity = count;
+    } else if (count > 0) {
+        rlUpdateVertexBuffer(batch.instanceBuffer, instances.data(), trimSize, 0);
+        rlUpdateVertexBuffer(batch.cellBuffer, origins.data(), originSize, 0);
+    }
+
+    batch.count = count;
+    batch.reversed = reversed;
+}
+
+void DrawStackBatch(const StackBatch &batch, Texture2D tex, Vector2 cellSize, int mipLevels, const StackView &view,
+                    bool depthTest) {
+    if (batch.vao == 0 || batch.count == 0) return;
+
+    // Whatever rlgl batched so far goes first to keep the draw order
+    rlDrawRenderBatchActive();
+
+    Vector2 sheetSize = {(float)tex.width, (float)tex.height};
+    float rotation = view.rotation * DEG2RAD;
+    int reversed = batch.reversed;
+    int alphaTest = depthTest;
+    float maxLod = (float)mipLevels;
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+
+    rlEnableShader(batch.shader.id);
+    rlSetUniformMatrix(rlGetLocationUniform(batch.shader.id, "mvp"), mvp);
+    SetUniform(batch.shader, "sheetSize", &sheetSize, RL_SHADER_UNIFORM_VEC2);
+    SetUniform(batch.shader, "cellSize", &cellSize, RL_SHADER_UNIFORM_VEC2);
+    SetUniform(batch.shader, "sliceCount", &batch.count, RL_SHADER_UNIFORM_INT);
+    SetUniform(batch.shader, "reversed", &reversed, RL_SHADER_UNIFORM_INT);
+    SetUniform(batch.shader, "center", &view.center, RL_SHADER_UNIFORM_VEC2);
+    SetUniform(batch.shader, "rotation", &rotation, RL_SHADER_UNIFORM_FLOAT);
+    SetUniform(batch.shader, "zoom", &view.zoom, RL_SHADER_UNIFORM_FLOAT);
+    SetUniform(batch.shader, "spacing", &view.spacing, RL_SHADER_UNIFORM_FLOAT);
+    SetUniform(batch.shader, "maxLod", &maxLod, RL_SHADER_UNIFORM_FLOAT);
+    SetUniform(batch.shader, "alphaTest", &alphaTest, RL_SHADER_UNIFORM_INT);
+
+    rlActiveTextureSlot(0);
+    rlEnableTexture(tex.id);
+    if (depthTest) rlEnableDepthTest();
+
+    rlEnableVertexArray(batch.vao);
+    rlDrawVertexArrayInstanced(0, 6, batch.count);
+    rlDisableVertexArray();
+
+    if (depthTest) rlDisableDepthTest();
+    rlDisableTexture();
+    rlDisableShader();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "raylib.h"
+#include "shader_cache.h"
+
+// Trimmed slices of one animation frame, stored on the GPU and drawn as instances of a unit
+// quad in a single call
+struct StackBatch {
+    Shader shader{};
+    unsigned int vao{0};
+    unsigned int quadBuffer{0};
+    unsigned int instanceBuffer{0};
+    unsigned int cellBuffer{0};
+    int capacity{0};
+    int count{0};
+    // Order the instances were uploaded in, top down for depth testing
+    bool reversed{false};
+};
+
+// Where and how the stack is seen, zoom is in screen pixels per texel and spacing is the
+// distance between two slices in texels
+struct StackView {
+    Vector2 center{0, 0};
+    float rotation{0.0f};
+    float zoom{8.0f};
+    float spacing{1.0f};
+};
+
+void LoadStackBatch(StackBatch &batch, ShaderCache &shaders);
+void UnloadStackBatch(StackBatch &batch);
+// Uploads the sheet rectangles of the slices and the top-left corners of their cells, bottom up
+void UpdateStackBatch(StackBatch &batch, const Rectangle *trims, const Vector2 *cells, int count, bool reversed);
+// Mip levels is the number of levels below the base one that can be sampled. The view is only
+// passed as uniforms.
+void DrawStackBatch(const StackBatch &batch, Texture2D tex, Vector2 cellSize, int mipLevels, const StackView &view,
+                    bool depthTest);
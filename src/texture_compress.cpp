@@ -0,0 +1,480 @@
+#include "texture_compress.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "hash.h"
+#include "rlgl.h"
+
+const char TEXTURE_CACHE_MAGIC[4] = {'M', 'S', 'T', 'X'};
+// Bumped whenever the encoder changes its output
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+const int DXT5_BLOCK_SIZE = 16;
+// Reported for identical images
+const float LOSSLESS_PSNR = 100.0f;
+
+const unsigned int GL_ENUM_TEXTURE_2D = 0x0DE1;
+const unsigned int GL_ENUM_TEXTURE_MAX_LEVEL = 0x813D;
+
+struct CompressedTextureHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    int32_t mipmaps;
+    float psnr;
+    uint32_t size;
+};
+
+// rlgl neither limits the levels of a texture nor reads compressed ones back
+struct GlCompressProcs {
+    void (*texParameteri)(unsigned int target, unsigned int name, int value);
+    void (*getCompressedTexImage)(unsigned int target, int level, void *data);
+};
+
+static GlCompressProcs gl{};
+
+static bool LoadCompressProcs() {
+    if (gl.texParameteri == nullptr) {
+        gl.texParameteri = (decltype(gl.texParameteri))glfwGetProcAddress("glTexParameteri");
+        gl.getCompressedTexImage =
+            (decltype(gl.getCompressedTexImage))glfwGetProcAddress("glGetCompressedTexImage");
+    }
+    return gl.texParameteri != nullptr && gl.getCompressedTexImage != nullptr;
+}
+
+bool IsTextureCompressionSupported() { return glfwExtensionSupported("GL_EXT_texture_compression_s3tc") != 0; }
+
+static int Square(int value) { return value * value; }
+
+static uint16_t PackColor565(const float color[3]) {
+    auto channel = [](float value, int max) { return (int)std::lround(std::clamp(value, 0.0f, 255.0f) * max / 255); };
+    return (uint16_t)(channel(color[0], 31) << 11 | channel(color[1], 63) << 5 | channel(color[2], 31));
+}
+
+// Expanded the way the GPU does, the top bits repeat into the low ones
+static void UnpackColor565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// The color half of a DXT5 block always has four colors, whatever the endpoint order
+static void GetColorPalette(uint16_t c0, uint16_t c1, int palette[4][3]) {
+    UnpackColor565(c0, palette[0]);
+    UnpackColor565(c1, palette[1]);
+    for (int i = 0; i < 3; i++) {
+        palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+        palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+    }
+}
+
+// Eight alphas between the endpoints, or six along with 0 and 255 when the first is not larger
+static void GetAlphaPalette(int a0, int a1, int palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    } else {
+        for (int i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Transparent texels take any color, only the visible ones count
+static uint32_t AssignColorIndices(const uint8_t texels[16][4], uint16_t c0, uint16_t c1, int &error) {
+    int palette[4][3];
+    GetColorPalette(c0, c1, palette);
+
+    uint32_t indices = 0;
+    error = 0;
+    for (int i = 0; i < 16; i++) {
+        if (texels[i][3] == 0) continue;
+        int best = 0, bestError = INT32_MAX;
+        for (int entry = 0; entry < 4; entry++) {
+            int entryError = Square(texels[i][0] - palette[entry][0]) + Square(texels[i][1] - palette[entry][1]) +
+                             Square(texels[i][2] - palette[entry][2]);
+            if (entryError < bestError) {
+                best = entry;
+                bestError = entryError;
+            }
+        }
+        indices |= (uint32_t)best << (2 * i);
+        error += bestError;
+    }
+    return indices;
+}
+
+static uint64_t AssignAlphaIndices(const uint8_t texels[16][4], int a0, int a1, int &error) {
+    int palette[8];
+    GetAlphaPalette(a0, a1, palette);
+
+    uint64_t indices = 0;
+    error = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestError = INT32_MAX;
+        for (int entry = 0; entry < 8; entry++) {
+            int entryError = Square(texels[i][3] - palette[entry]);
+            if (entryError < bestError) {
+                best = entry;
+                bestError = entryError;
+            }
+        }
+        indices |= (uint64_t)best << (3 * i);
+        error += bestError;
+    }
+    return indices;
+}
+
+// Endpoints at the extremes of the principal axis of the visible colors, then refitted once by
+// least squares to the indices they gave
+static void EncodeColorBlock(const uint8_t texels[16][4], uint8_t *block) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    int visible = 0;
+    for (int i = 0; i < 16; i++) {
+        if (texels[i][3] == 0) continue;
+        for (int c = 0; c < 3; c++) mean[c] += texels[i][c];
+        visible++;
+    }
+    std::memset(block, 0, 8);
+    if (visible == 0) return;
+    for (float &channel : mean) channel /= visible;
+
+    float covariance[3][3] = {};
+    for (int i = 0; i < 16; i++) {
+        if (texels[i][3] == 0) continue;
+        float delta[3] = {texels[i][0] - mean[0], texels[i][1] - mean[1], texels[i][2] - mean[2]};
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 3; column++) covariance[row][column] += delta[row] * delta[column];
+        }
+    }
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 4; iteration++) {
+        float next[3];
+        for (int row = 0; row < 3; row++)
+            next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+        float length = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+        if (length == 0.0f) break;
+        for (int c = 0; c < 3; c++) axis[c] = next[c] / length;
+    }
+
+    float minProjection = INFINITY, maxProjection = -INFINITY;
+    float endpoints[2][3] = {};
+    for (int i = 0; i < 16; i++) {
+        if (texels[i][3] == 0) continue;
+        float projection = texels[i][0] * axis[0] + texels[i][1] * axis[1] + texels[i][2] * axis[2];
+        if (projection > maxProjection) {
+            maxProjection = projection;
+            for (int c = 0; c < 3; c++) endpoints[0][c] = texels[i][c];
+        }
+        if (projection < minProjection) {
+            minProjection = projection;
+            for (int c = 0; c < 3; c++) endpoints[1][c] = texels[i][c];
+        }
+    }
+
+    uint16_t c0 = PackColor565(endpoints[0]), c1 = PackColor565(endpoints[1]);
+    int error = 0;
+    uint32_t indices = AssignColorIndices(texels, c0, c1, error);
+
+    // Weight of the first endpoint for each index
+    const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; i++) {
+        if (texels[i][3] == 0) continue;
+        float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; c++) {
+            ax[c] += a * texels[i][c];
+            bx[c] += b * texels[i][c];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) > 1e-6f) {
+        float refitted[2][3];
+        for (int c = 0; c < 3; c++) {
+            refitted[0][c] = (bb * ax[c] - ab * bx[c]) / determinant;
+            refitted[1][c] = (aa * bx[c] - ab * ax[c]) / determinant;
+        }
+        uint16_t refitted0 = PackColor565(refitted[0]), refitted1 = PackColor565(refitted[1]);
+        int refittedError = 0;
+        uint32_t refittedIndices = AssignColorIndices(texels, refitted0, refitted1, refittedError);
+        if (refittedError < error) {
+            c0 = refitted0;
+            c1 = refitted1;
+            indices = refittedIndices;
+        }
+    }
+
+    // Some decoders read equal or ascending endpoints as the three color mode of DXT1, swapping
+    // them swaps the indices 0 and 1, and 2 and 3
+    if (c0 < c1) {
+        std::swap(c0, c1);
+        indices ^= 0x55555555u;
+    } else if (c0 == c1) {
+        indices = 0;
+    }
+    block[0] = (uint8_t)c0;
+    block[1] = (uint8_t)(c0 >> 8);
+    block[2] = (uint8_t)c1;
+    block[3] = (uint8_t)(c1 >> 8);
+    for (int i = 0; i < 4; i++) block[4 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+// Pixel art alpha is mostly 0 and 255, which the six alpha mode keeps exact around the other values
+static void EncodeAlphaBlock(const uint8_t texels[16][4], uint8_t *block) {
+    int minAlpha = 255, maxAlpha = 0, minInner = 255, maxInner = 0;
+    for (int i = 0; i < 16; i++) {
+        int alpha = texels[i][3];
+        minAlpha = std::min(minAlpha, alpha);
+        maxAlpha = std::max(maxAlpha, alpha);
+        if (alpha == 0 || alpha == 255) continue;
+        minInner = std::min(minInner, alpha);
+        maxInner = std::max(maxInner, alpha);
+    }
+    if (minInner > maxInner) minInner = maxInner = 0;
+
+    int error = 0, innerError = 0;
+    uint64_t indices = AssignAlphaIndices(texels, maxAlpha, minAlpha, error);
+    uint64_t innerIndices = AssignAlphaIndices(texels, minInner, maxInner, innerError);
+    int a0 = maxAlpha, a1 = minAlpha;
+    if (innerError < error) {
+        a0 = minInner;
+        a1 = maxInner;
+        indices = innerIndices;
+    }
+
+    block[0] = (uint8_t)a0;
+    block[1] = (uint8_t)a1;
+    for (int i = 0; i < 6; i++) block[2 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+static void DecodeBlock(const uint8_t *block, uint8_t texels[16][4]) {
+    int alphas[8];
+    GetAlphaPalette(block[0], block[1], alphas);
+    uint64_t alphaIndices = 0;
+    for (int i = 0; i < 6; i++) alphaIndices |= (uint64_t)block[2 + i] << (8 * i);
+
+    int colors[4][3];
+    GetColorPalette((uint16_t)(block[8] | block[9] << 8), (uint16_t)(block[10] | block[11] << 8), colors);
+    uint32_t colorIndices = 0;
+    for (int i = 0; i < 4; i++) colorIndices |= (uint32_t)block[12 + i] << (8 * i);
+
+    for (int i = 0; i < 16; i++) {
+        const int *color = colors[(colorIndices >> (2 * i)) & 3];
+        for (int c = 0; c < 3; c++) texels[i][c] = (uint8_t)color[c];
+        texels[i][3] = (uint8_t)alphas[(alphaIndices >> (3 * i)) & 7];
+    }
+}
+
+static void EncodeLevel(const uint8_t *pixels, int width, int height, uint8_t *blocks, ThreadPool &pool) {
+    int blocksX = width / 4;
+    ParallelFor(pool, height / 4, [&](int begin, int end) {
+        uint8_t texels[16][4];
+        for (int by = begin; by < end; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                for (int y = 0; y < 4; y++)
+                    std::memcpy(texels[4 * y], pixels + ((size_t)(4 * by + y) * width + 4 * bx) * 4, 16);
+                uint8_t *block = blocks + ((size_t)by * blocksX + bx) * DXT5_BLOCK_SIZE;
+                EncodeAlphaBlock(texels, block);
+                EncodeColorBlock(texels, block + 8);
+            }
+        }
+    });
+}
+
+static std::string GetCompressedPath(const std::string &directory, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.dxt", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+static bool LoadCompressedLevels(const std::string &path, const CompressedTextureHeader &expected, void *data,
+                                 float &psnr) {
+    std::ifstream file(path, std::ios::binary);
+    CompressedTextureHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    bool matches = std::memcmp(header.magic, TEXTURE_CACHE_MAGIC, 4) == 0 && header.version == expected.version &&
+                   header.key == expected.key && header.width == expected.width &&
+                   header.height == expected.height && header.mipmaps == expected.mipmaps &&
+                   header.size == expected.size;
+    if (!matches || !file.read(static_cast<char *>(data), header.size)) return false;
+
+    psnr = header.psnr;
+    return true;
+}
+
+static void SaveCompressedLevels(const std::string &directory, const std::string &path,
+                                 const CompressedTextureHeader &header, const void *data) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(static_cast<const char *>(data), header.size);
+        if (!file) return;
+    }
+    std::filesystem::rename(tempPath, path, error);
+}
+
+CompressionResult CompressImageDxt5(Image &image, uint64_t contentHash, const std::string &cacheDirectory,
+                                    ThreadPool &pool) {
+    CompressionResult result;
+    if (image.data == nullptr || image.width % 4 != 0 || image.height % 4 != 0) return result;
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return result;
+
+    // Levels of whole blocks, raylib sizes the others as if they were
+    int levels = 1;
+    while (levels < image.mipmaps && (image.width >> levels) >= 4 && (image.width >> levels) % 4 == 0 &&
+           (image.height >> levels) >= 4 && (image.height >> levels) % 4 == 0)
+        levels++;
+
+    size_t size = 0;
+    for (int level = 0; level < levels; level++) size += (size_t)(image.width >> level) * (image.height >> level);
+
+    CompressedTextureHeader header{};
+    std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, 4);
+    header.version = TEXTURE_CACHE_VERSION;
+    header.width = image.width;
+    header.height = image.height;
+    header.mipmaps = levels;
+    header.size = (uint32_t)size;
+    header.key = HashBytes(&header.width, 3 * sizeof(int32_t), contentHash);
+
+    uint8_t *blocks = static_cast<uint8_t *>(MemAlloc((unsigned int)size));
+    if (blocks == nullptr) return result;
+    std::string path = cacheDirectory.empty() ? "" : GetCompressedPath(cacheDirectory, header.key);
+    result.cached = !path.empty() && LoadCompressedLevels(path, header, blocks, result.psnr);
+    if (result.cached) {
+        // Recently used, the last to be pruned
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    }
+
+    if (!result.cached) {
+        const uint8_t *pixels = static_cast<const uint8_t *>(image.data);
+        uint8_t *level = blocks;
+        for (int i = 0; i < levels; i++) {
+            int width = image.width >> i, height = image.height >> i;
+            EncodeLevel(pixels, width, height, level, pool);
+            pixels += (size_t)width * height * 4;
+            level += (size_t)width * height;
+        }
+
+        Image source = {image.data, image.width, image.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        Image decompressed = DecompressImageDxt5({blocks, image.width, image.height, 1,
+                                                  PIXELFORMAT_COMPRESSED_DXT5_RGBA});
+        result.psnr = header.psnr = GetImagePsnr(source, decompressed);
+        UnloadImage(decompressed);
+        if (!path.empty()) SaveCompressedLevels(cacheDirectory, path, header, blocks);
+    }
+
+    UnloadImage(image);
+    image = {blocks, header.width, header.height, levels, PIXELFORMAT_COMPRESSED_DXT5_RGBA};
+    result.compressed = true;
+    return result;
+}
+
+uint64_t PruneTextureCache(const std::string &cacheDirectory, uint64_t budget) {
+    struct CachedFile {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        uint64_t size;
+    };
+    std::vector<CachedFile> files;
+    uint64_t total = 0;
+    std::error_code error;
+    for (auto it = std::filesystem::directory_iterator(cacheDirectory, error);
+         !error && it != std::filesystem::directory_iterator(); it.increment(error)) {
+        if (!it->is_regular_file() || it->path().extension() != ".dxt") continue;
+        std::error_code fileError;
+        CachedFile file{it->path(), it->last_write_time(fileError), it->file_size(fileError)};
+        if (fileError) continue;
+        files.push_back(file);
+        total += file.size;
+    }
+    if (total <= budget) return 0;
+
+    std::sort(files.begin(), files.end(),
+              [](const CachedFile &a, const CachedFile &b) { return a.lastUse < b.lastUse; });
+    uint64_t deleted = 0;
+    for (const CachedFile &file : files) {
+        if (total - deleted <= budget) break;
+        if (std::filesystem::remove(file.path, error)) deleted += file.size;
+    }
+    return deleted;
+}
+
+Image DecompressImageDxt5(const Image &image) {
+    if (image.data == nullptr || image.format != PIXELFORMAT_COMPRESSED_DXT5_RGBA) return Image{};
+
+    Image decompressed = GenImageColor(image.width, image.height, BLANK);
+    const uint8_t *block = static_cast<const uint8_t *>(image.data);
+    uint8_t *pixels = static_cast<uint8_t *>(decompressed.data);
+    uint8_t texels[16][4];
+    for (int by = 0; by < image.height / 4; by++) {
+        for (int bx = 0; bx < image.width / 4; bx++, block += DXT5_BLOCK_SIZE) {
+            DecodeBlock(block, texels);
+            for (int y = 0; y < 4; y++)
+                std::memcpy(pixels + ((size_t)(4 * by + y) * image.width + 4 * bx) * 4, texels[4 * y], 16);
+        }
+    }
+    return decompressed;
+}
+
+float GetImagePsnr(const Image &source, const Image &decompressed) {
+    if (source.data == nullptr || decompressed.data == nullptr || source.width != decompressed.width ||
+        source.height != decompressed.height || source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 ||
+        decompressed.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        return 0.0f;
+
+    const uint8_t *expected = static_cast<const uint8_t *>(source.data);
+    const uint8_t *actual = static_cast<const uint8_t *>(decompressed.data);
+    double error = 0.0;
+    size_t samples = 0;
+    for (size_t i = 0; i < (size_t)source.width * source.height; i++, expected += 4, actual += 4) {
+        int channels = expected[3] == 0 ? 1 : 4;
+        for (int c = 4 - channels; c < 4; c++) error += Square(expected[c] - actual[c]);
+        samples += channels;
+    }
+    if (error == 0.0) return LOSSLESS_PSNR;
+    return (float)(10.0 * std::log10(255.0 * 255.0 * samples / error));
+}
+
+void LimitTextureLevels(Texture2D tex) {
+    if (tex.id == 0 || !LoadCompressProcs()) return;
+    rlEnableTexture(tex.id);
+    gl.texParameteri(GL_ENUM_TEXTURE_2D, GL_ENUM_TEXTURE_MAX_LEVEL, std::max(tex.mipmaps, 1) - 1);
+    rlDisableTexture();
+}
+
+Image LoadImageFromSheetTexture(Texture2D tex) {
+    if (tex.format != PIXELFORMAT_COMPRESSED_DXT5_RGBA) return LoadImageFromTexture(tex);
+    if (!LoadCompressProcs()) return Image{};
+
+    Image compressed = {MemAlloc(GetPixelDataSize(tex.width, tex.height, tex.format)), tex.width, tex.height, 1,
+                        PIXELFORMAT_COMPRESSED_DXT5_RGBA};
+    rlEnableTexture(tex.id);
+    gl.getCompressedTexImage(GL_ENUM_TEXTURE_2D, 0, compressed.data);
+    rlDisableTexture();
+    Image image = DecompressImageDxt5(compressed);
+    UnloadImage(compressed);
+    return image;
+}
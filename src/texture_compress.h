@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "raylib.h"
+#include "thread_pool.h"
+
+struct CompressionResult {
+    bool compressed{false};
+    // Read back from the cache directory instead of encoded
+    bool cached{false};
+    // Of the base level against the source, in dB
+    float psnr{0.0f};
+};
+
+// Whether the driver samples DXT5 textures, needs the GL context
+bool IsTextureCompressionSupported();
+// Replaces a RGBA8 image and its mip levels with DXT5 blocks, encoded on the pool or read from
+// the cache directory when the same content was compressed before. Blocks cover 4x4 texels, so
+// images whose size is not a multiple of 4 are left as they are and the mip chain stops at the
+// first level that isn't. An empty directory skips the cache.
+CompressionResult CompressImageDxt5(Image &image, uint64_t contentHash, const std::string &cacheDirectory,
+                                    ThreadPool &pool);
+// Deletes the least recently used compressed sheets of the cache directory until the others take
+// at most budget bytes. Cache hits refresh the modification time of their file, which gives the
+// order. Returns the number of bytes deleted.
+uint64_t PruneTextureCache(const std::string &cacheDirectory, uint64_t budget);
+// RGBA8 copy of the base level of a DXT5 image
+Image DecompressImageDxt5(const Image &image);
+// Peak signal to noise ratio of a decompressed image against its source. The color of
+// transparent source texels is never seen and doesn't count.
+float GetImagePsnr(const Image &source, const Image &decompressed);
+
+// Uploaded compressed chains may stop short of 1x1, the texture is kept complete by limiting
+// its levels to the uploaded ones
+void LimitTextureLevels(Texture2D tex);
+// Like LoadImageFromTexture, but DXT5 textures are read back and decompressed
+Image LoadImageFromSheetTexture(Texture2D tex);
@@ -0,0 +1,187 @@
+#include "texture_manager.h"
+
+#include <algorithm>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "mipmaps.h"
+#include "rlgl.h"
+
+// Released textures kept for reuse, a reload only ever needs one
+const size_t MAX_SPARE_TEXTURES = 2;
+
+const unsigned int GL_ENUM_TEXTURE_2D = 0x0DE1;
+
+// rlUpdateTexture only writes the base level, spares are refilled level by level here
+struct GlTextureProcs {
+    void (*texSubImage2D)(unsigned int target, int level, int x, int y, int width, int height, unsigned int format,
+                          unsigned int type, const void *pixels);
+    void (*compressedTexSubImage2D)(unsigned int target, int level, int x, int y, int width, int height,
+                                    unsigned int format, int size, const void *data);
+};
+
+static GlTextureProcs gl{};
+
+static bool LoadTextureProcs() {
+    if (gl.texSubImage2D == nullptr) {
+        gl.texSubImage2D = (decltype(gl.texSubImage2D))glfwGetProcAddress("glTexSubImage2D");
+        gl.compressedTexSubImage2D =
+            (decltype(gl.compressedTexSubImage2D))glfwGetProcAddress("glCompressedTexSubImage2D");
+    }
+    return gl.texSubImage2D != nullptr && gl.compressedTexSubImage2D != nullptr;
+}
+
+static bool IsCompressedFormat(int format) { return format >= PIXELFORMAT_COMPRESSED_DXT1_RGB; }
+
+// Writes every level of the image into a texture allocated with the same size, format and levels
+static bool RefillTexture(Texture2D tex, const Image &image) {
+    if (!LoadTextureProcs()) return false;
+
+    unsigned int internalFormat = 0, format = 0, type = 0;
+    rlGetGlTextureFormats(image.format, &internalFormat, &format, &type);
+
+    rlEnableTexture(tex.id);
+    const unsigned char *data = static_cast<const unsigned char *>(image.data);
+    for (int level = 0; level < image.mipmaps; level++) {
+        int width = std::max(image.width >> level, 1);
+        int height = std::max(image.height >> level, 1);
+        int size = GetPixelDataSize(width, height, image.format);
+        if (IsCompressedFormat(image.format))
+            gl.compressedTexSubImage2D(GL_ENUM_TEXTURE_2D, level, 0, 0, width, height, internalFormat, size, data);
+        else
+            gl.texSubImage2D(GL_ENUM_TEXTURE_2D, level, 0, 0, width, height, format, type, data);
+        data += size;
+    }
+    rlDisableTexture();
+    return true;
+}
+
+static void TrackTexture(TextureManager &manager, unsigned int id, size_t bytes) {
+    manager.textures[id] = ManagedTexture{bytes, ++manager.clock, nullptr};
+    manager.bytes += bytes;
+    manager.stats.peakBytes = std::max(manager.stats.peakBytes, manager.bytes);
+}
+
+static void UntrackTexture(TextureManager &manager, unsigned int id) {
+    auto managed = manager.textures.find(id);
+    if (managed == manager.textures.end()) return;
+    manager.bytes -= managed->second.bytes;
+    manager.textures.erase(managed);
+}
+
+static Texture2D TakeSpareTexture(TextureManager &manager, const Image &image) {
+    for (auto spare = manager.spares.begin(); spare != manager.spares.end(); spare++) {
+        bool matches = spare->width == image.width && spare->height == image.height &&
+                       spare->format == image.format && spare->mipmaps == image.mipmaps;
+        if (!matches) continue;
+
+        Texture2D tex = *spare;
+        manager.spares.erase(spare);
+        return tex;
+    }
+    return Texture2D{};
+}
+
+Texture2D LoadManagedTexture(TextureManager &manager, const Image &image) {
+    if (image.data == nullptr) return Texture2D{};
+
+    Texture2D tex = TakeSpareTexture(manager, image);
+    if (tex.id != 0 && RefillTexture(tex, image)) {
+        manager.stats.reuses++;
+        manager.textures[tex.id].lastUse = ++manager.clock;
+        return tex;
+    }
+    if (tex.id != 0) {
+        UntrackTexture(manager, tex.id);
+        UnloadTexture(tex);
+    }
+
+    tex = LoadTextureFromImage(image);
+    if (tex.id == 0) return tex;
+    manager.stats.uploads++;
+    TrackTexture(manager, tex.id, GetTextureMemorySize(tex));
+    EnforceTextureBudget(manager);
+    return tex;
+}
+
+void UnloadManagedTexture(TextureManager &manager, Texture2D tex) {
+    if (tex.id == 0) return;
+
+    auto managed = manager.textures.find(tex.id);
+    if (managed != manager.textures.end()) managed->second.evict = nullptr;
+    if (managed != manager.textures.end() && manager.bytes <= manager.budget) {
+        manager.spares.insert(manager.spares.begin(), tex);
+        if (manager.spares.size() <= MAX_SPARE_TEXTURES) return;
+        // The oldest spare goes instead
+        tex = manager.spares.back();
+        manager.spares.pop_back();
+    }
+
+    UntrackTexture(manager, tex.id);
+    UnloadTexture(tex);
+}
+
+RenderTexture2D LoadManagedRenderTexture(TextureManager &manager, int width, int height) {
+    RenderTexture2D target = LoadRenderTexture(width, height);
+    if (target.id == 0) return target;
+
+    // The depth renderbuffer takes as much as the color texture
+    TrackTexture(manager, target.texture.id, 2 * GetTextureMemorySize(target.texture));
+    EnforceTextureBudget(manager);
+    return target;
+}
+
+void UnloadManagedRenderTexture(TextureManager &manager, RenderTexture2D target) {
+    if (target.id == 0) return;
+    UntrackTexture(manager, target.texture.id);
+    UnloadRenderTexture(target);
+}
+
+void SetTextureEvictable(TextureManager &manager, Texture2D tex, std::function<void()> evict) {
+    auto managed = manager.textures.find(tex.id);
+    if (managed == manager.textures.end()) return;
+    managed->second.lastUse = ++manager.clock;
+    managed->second.evict = std::move(evict);
+    if (managed->second.evict) EnforceTextureBudget(manager);
+}
+
+void EnforceTextureBudget(TextureManager &manager) {
+    while (manager.bytes > manager.budget && !manager.spares.empty()) {
+        Texture2D spare = manager.spares.back();
+        manager.spares.pop_back();
+        UntrackTexture(manager, spare.id);
+        UnloadTexture(spare);
+    }
+
+    while (manager.bytes > manager.budget) {
+        auto oldest = manager.textures.end();
+        for (auto managed = manager.textures.begin(); managed != manager.textures.end(); managed++) {
+            if (managed->second.evict && (oldest == manager.textures.end() ||
+                                          managed->second.lastUse < oldest->second.lastUse))
+                oldest = managed;
+        }
+        if (oldest == manager.textures.end()) break;
+
+        // The owner unloads it through UnloadManagedTexture, which finds the budget exceeded
+        unsigned int id = oldest->first;
+        std::function<void()> evict = std::move(oldest->second.evict);
+        manager.stats.evictions++;
+        evict();
+        UntrackTexture(manager, id);
+    }
+}
+
+void UnloadTextureManager(TextureManager &manager) {
+    for (Texture2D spare : manager.spares) {
+        UntrackTexture(manager, spare.id);
+        UnloadTexture(spare);
+    }
+    manager.spares.clear();
+}
+
+void LogTextureStats(const TextureManager &manager) {
+    const TextureStats &stats = manager.stats;
+    TraceLog(LOG_INFO, "TEXTURE: %d resident, %.1f MB of %.1f MB, %.1f MB at peak", (int)manager.textures.size(),
+             manager.bytes / 1048576.0, manager.budget / 1048576.0, stats.peakBytes / 1048576.0);
+    TraceLog(LOG_INFO, "TEXTURE: %d uploads, %d reused, %d evicted", stats.uploads, stats.reuses, stats.evictions);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "raylib.h"
+
+struct ManagedTexture {
+    size_t bytes{0};
+    uint64_t lastUse{0};
+    // Called to make room, the owner then unloads the texture. Textures without one stay resident.
+    std::function<void()> evict;
+};
+
+struct TextureStats {
+    int uploads{0};
+    // Uploads into a released texture of the same size and format
+    int reuses{0};
+    int evictions{0};
+    size_t peakBytes{0};
+};
+
+// GPU memory of every texture the application loads, by texture id. Past the budget, the least
+// recently used evictable textures are handed back to their owners. Released textures are kept
+// as spares for the next upload of the same size, so reloading a sheet allocates nothing.
+struct TextureManager {
+    std::unordered_map<unsigned int, ManagedTexture> textures;
+    std::vector<Texture2D> spares;
+    size_t bytes{0};
+    size_t budget{512u << 20};
+    uint64_t clock{0};
+    TextureStats stats;
+};
+
+// Like LoadTextureFromImage with the mip levels of the image, reusing a spare when one matches
+Texture2D LoadManagedTexture(TextureManager &manager, const Image &image);
+// Keeps the texture as a spare while within the budget, unloads it otherwise
+void UnloadManagedTexture(TextureManager &manager, Texture2D tex);
+// Color and depth attachments are both counted
+RenderTexture2D LoadManagedRenderTexture(TextureManager &manager, int width, int height);
+void UnloadManagedRenderTexture(TextureManager &manager, RenderTexture2D target);
+// Marks the texture as used now and sets how it can be evicted, nullptr keeps it resident
+void SetTextureEvictable(TextureManager &manager, Texture2D tex, std::function<void()> evict);
+// Unloads the spares, then evicts textures until everything fits in the budget
+void EnforceTextureBudget(TextureManager &manager);
+// Unloads the spares, the other textures are unloaded by their owners
+void UnloadTextureManager(TextureManager &manager);
+void LogTextureStats(const TextureManager &manager);
@@ -0,0 +1,76 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+static void RunWorker(ThreadPool &pool) {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+
+    while (true) {
+        pool.wake.wait(lock, [&pool] { return !pool.running || !pool.tasks.empty(); });
+        if (!pool.running && pool.tasks.empty()) break;
+
+        std::function<void()> task = std::move(pool.tasks.front());
+        pool.tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+void StartThreadPool(ThreadPool &pool, int threads) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    pool.running = true;
+    for (int i = 0; i < threads; i++) pool.workers.emplace_back(RunWorker, std::ref(pool));
+}
+
+void StopThreadPool(ThreadPool &pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.running = false;
+    }
+    pool.wake.notify_all();
+    for (std::thread &worker : pool.workers) worker.join();
+    pool.workers.clear();
+}
+
+void SubmitTask(ThreadPool &pool, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.tasks.push_back(std::move(task));
+    }
+    pool.wake.notify_one();
+}
+
+void ParallelFor(ThreadPool &pool, int count, const std::function<void(int begin, int end)> &body) {
+    if (count <= 0) return;
+    if (pool.workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    // A few chunks per worker so uneven chunks even out
+    int chunks = std::min(count, std::max(1, (int)pool.workers.size() * 4));
+    int chunkSize = (count + chunks - 1) / chunks;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    int remaining = 0;
+
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        int end = std::min(count, begin + chunkSize);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            remaining++;
+        }
+        SubmitTask(pool, [&, begin, end] {
+            body(begin, end);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) finished.notify_one();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&remaining] { return remaining == 0; });
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    bool running{false};
+};
+
+// Zero threads uses one per hardware thread
+void StartThreadPool(ThreadPool &pool, int threads = 0);
+void StopThreadPool(ThreadPool &pool);
+void SubmitTask(ThreadPool &pool, std::function<void()> task);
+// Splits [0, count) into chunks run on the pool and returns once all of them are done
+void ParallelFor(ThreadPool &pool, int count, const std::function<void(int begin, int end)> &body);
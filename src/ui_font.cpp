@@ -0,0 +1,55 @@
+#include "ui_font.h"
+
+#include <vector>
+
+#include "assets.h"
+#include "inflate.h"
+#include "ui_font_metrics.h"
+
+UiFontData DecodeUiFont() {
+    const int glyphCount = sizeof(UI_FONT_GLYPHS) / sizeof(UI_FONT_GLYPHS[0]);
+    const int pixelCount = UI_FONT_ATLAS_WIDTH * UI_FONT_ATLAS_HEIGHT;
+
+    // Raw DEFLATE from CompressData, inflated into a buffer of the atlas size. DecompressData
+    // would allocate 64 MB for it at every start.
+    UiFontData data;
+    std::vector<unsigned char> alpha(pixelCount);
+    if (!InflateData(ui_font_atlas, ui_font_atlas_size, alpha.data(), alpha.size())) return data;
+
+    // Same white gray-alpha atlas raylib builds when it rasterizes the font itself
+    unsigned char *pixels = static_cast<unsigned char *>(MemAlloc(pixelCount * 2));
+    for (int i = 0; i < pixelCount; i++) {
+        pixels[2 * i] = 255;
+        pixels[2 * i + 1] = alpha[i];
+    }
+    data.atlas = {pixels, UI_FONT_ATLAS_WIDTH, UI_FONT_ATLAS_HEIGHT, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+
+    // Allocated like raylib's own fonts so UnloadFont releases them, glyph images are left
+    // empty as only ImageDrawText would use them
+    Font &font = data.font;
+    font.baseSize = UI_FONT_SIZE;
+    font.glyphCount = glyphCount;
+    font.glyphPadding = UI_FONT_PADDING;
+    font.recs = static_cast<Rectangle *>(MemAlloc(glyphCount * sizeof(Rectangle)));
+    font.glyphs = static_cast<GlyphInfo *>(MemAlloc(glyphCount * sizeof(GlyphInfo)));
+    for (int i = 0; i < glyphCount; i++) {
+        const int *glyph = UI_FONT_GLYPHS[i];
+        font.glyphs[i].value = glyph[0];
+        font.glyphs[i].offsetX = glyph[1];
+        font.glyphs[i].offsetY = glyph[2];
+        font.glyphs[i].advanceX = glyph[3];
+        font.recs[i] = {(float)glyph[4], (float)glyph[5], (float)glyph[6], (float)glyph[7]};
+    }
+
+    return data;
+}
+
+Font UploadUiFont(UiFontData &data) {
+    if (data.atlas.data == nullptr) return GetFontDefault();
+
+    Font font = data.font;
+    font.texture = LoadTextureFromImage(data.atlas);
+    UnloadImage(data.atlas);
+    data = UiFontData{};
+    return font;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "raylib.h"
+
+// The UI font, rasterized at build time by tools/font_baker.cpp. Decoding the embedded atlas
+// needs no GL context, so it can run on another thread while the window opens.
+struct UiFontData {
+    // Glyph tables filled, texture not uploaded yet
+    Font font{};
+    Image atlas{};
+};
+
+UiFontData DecodeUiFont();
+// Uploads the atlas at once and frees it, the font is released with UnloadFont. Falls back to
+// raylib's default font when decoding failed.
+Font UploadUiFont(UiFontData &data);
@@ -0,0 +1,150 @@
+#include "vox_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "byte_reader.h"
+
+const int VOX_MAX_SIZE = 256;
+// Slices wrap into a grid past this sheet width, and neither way gets more cells than the
+// frame spinners of the configuration panel allow
+const int MAX_ROW_WIDTH = 4096;
+const int MAX_GRID_CELLS = 100;
+
+static constexpr uint32_t ChunkId(const char *id) {
+    return (uint32_t)id[0] | ((uint32_t)id[1] << 8) | ((uint32_t)id[2] << 16) | ((uint32_t)id[3] << 24);
+}
+
+struct VoxModel {
+    int sizeX{0};
+    int sizeY{0};
+    int sizeZ{0};
+    // x, y, z and colour index, one byte each
+    const unsigned char *voxels{nullptr};
+    uint32_t voxelCount{0};
+    // Indexed by colour index, index 0 is empty
+    uint32_t palette[256]{};
+};
+
+// The palette of files saved without one: a 6x6x6 colour cube without black, then ramps of
+// red, green, blue and grey
+static void SetDefaultPalette(uint32_t *palette) {
+    const uint32_t CUBE[6] = {0xFF, 0xCC, 0x99, 0x66, 0x33, 0x00};
+    const uint32_t RAMP[10] = {0xEE, 0xDD, 0xBB, 0xAA, 0x88, 0x77, 0x55, 0x44, 0x22, 0x11};
+
+    int index = 0;
+    palette[index++] = 0;
+    for (int r = 0; r < 6; r++) {
+        for (int g = 0; g < 6; g++) {
+            for (int b = 0; b < 6 && index < 216; b++)
+                palette[index++] = CUBE[r] | (CUBE[g] << 8) | (CUBE[b] << 16) | 0xFF000000u;
+        }
+    }
+    for (int channel = 0; channel < 4; channel++) {
+        for (uint32_t value : RAMP) {
+            uint32_t color = channel == 3 ? value | (value << 8) | (value << 16) : value << (8 * channel);
+            palette[index++] = color | 0xFF000000u;
+        }
+    }
+}
+
+// Walks the children of the main chunk, keeping the first model and the palette
+static bool ReadVoxFile(Reader &reader, VoxModel &model) {
+    if (ReadDword(reader) != ChunkId("VOX ")) return false;
+    ReadDword(reader); // Version
+    if (ReadDword(reader) != ChunkId("MAIN")) return false;
+    uint32_t mainContent = ReadDword(reader);
+    uint32_t mainChildren = ReadDword(reader);
+    Skip(reader, mainContent);
+    if (!reader.ok) return false;
+    size_t mainEnd = std::min(reader.pos + mainChildren, reader.size);
+
+    SetDefaultPalette(model.palette);
+    bool sized = false;
+
+    while (reader.pos + 12 <= mainEnd) {
+        uint32_t id = ReadDword(reader);
+        size_t contentSize = ReadDword(reader);
+        size_t childrenSize = ReadDword(reader);
+        size_t chunkEnd = reader.pos + contentSize + childrenSize;
+        if (chunkEnd > mainEnd) return false;
+
+        if (id == ChunkId("SIZE") && !sized) {
+            model.sizeX = (int)ReadDword(reader);
+            model.sizeY = (int)ReadDword(reader);
+            model.sizeZ = (int)ReadDword(reader);
+            sized = reader.ok;
+        } else if (id == ChunkId("XYZI") && sized && model.voxels == nullptr) {
+            uint32_t count = ReadDword(reader);
+            if (reader.ok && (size_t)count * 4 <= chunkEnd - reader.pos) {
+                model.voxels = reader.data + reader.pos;
+                model.voxelCount = count;
+            }
+        } else if (id == ChunkId("RGBA") && contentSize >= 256 * 4) {
+            // Entry i colours index i + 1, voxels are always opaque
+            for (int i = 0; i < 255; i++) model.palette[i + 1] = ReadDword(reader) | 0xFF000000u;
+        }
+
+        // Chunks are skipped by their size, whatever was read of them
+        reader.ok = true;
+        reader.pos = chunkEnd;
+    }
+
+    auto validSize = [](int size) { return size > 0 && size <= VOX_MAX_SIZE; };
+    return model.voxels != nullptr && validSize(model.sizeX) && validSize(model.sizeY) && validSize(model.sizeZ);
+}
+
+static SheetLayout GetVoxLayout(int width, int height, int slices) {
+    if (slices <= MAX_GRID_CELLS && width * slices <= MAX_ROW_WIDTH)
+        return MakeSheetLayout(LayoutOrder::RowMajor, slices, 1);
+
+    // Close to square, the empty cells of the last row are empty slices at the top
+    int columns = (int)std::ceil(std::sqrt((float)slices * height / width));
+    columns = std::max(std::min(columns, MAX_GRID_CELLS), (slices + MAX_GRID_CELLS - 1) / MAX_GRID_CELLS);
+    return MakeSheetLayout(LayoutOrder::SliceGrid, columns, (slices + columns - 1) / columns);
+}
+
+bool IsVoxFile(const char *path) { return IsFileExtension(path, ".vox"); }
+
+VoxSheet LoadVoxFromMemory(const unsigned char *data, int size, ThreadPool &pool) {
+    VoxSheet sheet;
+    if (data == nullptr || size <= 0) return sheet;
+
+    Reader reader{data, (size_t)size, 0, true};
+    VoxModel model;
+    if (!ReadVoxFile(reader, model)) return sheet;
+
+    SheetLayout layout = GetVoxLayout(model.sizeX, model.sizeY, model.sizeZ);
+    int width = GetLayoutColumns(layout) * model.sizeX;
+    int height = GetLayoutRows(layout) * model.sizeY;
+    // Zeroed, so the cells start transparent
+    uint32_t *pixels = static_cast<uint32_t *>(MemAlloc((unsigned int)((size_t)width * height * 4)));
+    if (pixels == nullptr) return sheet;
+
+    // Offset of the bottom-left pixel of every slice on the sheet as stored, which is flipped
+    // vertically once loaded like any other sheet. y grows up, so rows are written bottom up.
+    Vector2 cellSize = {(float)model.sizeX, (float)model.sizeY};
+    std::vector<size_t> origins(model.sizeZ);
+    for (int z = 0; z < model.sizeZ; z++) {
+        Rectangle cell = GetLayoutCell(layout, cellSize, z, 0);
+        size_t bottom = (size_t)height - 1 - (size_t)cell.y;
+        origins[z] = bottom * width + (size_t)cell.x;
+    }
+
+    // Every voxel owns its pixel, the list is split between the threads as it is
+    ParallelFor(pool, (int)model.voxelCount, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const unsigned char *voxel = model.voxels + (size_t)i * 4;
+            int x = voxel[0], y = voxel[1], z = voxel[2];
+            if (x >= model.sizeX || y >= model.sizeY || z >= model.sizeZ || voxel[3] == 0) continue;
+            pixels[origins[z] - (size_t)y * width + x] = model.palette[voxel[3]];
+        }
+    });
+
+    sheet.image = Image{pixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    sheet.layout = layout;
+    return sheet;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "raylib.h"
+#include "sheet_layout.h"
+#include "thread_pool.h"
+
+// A MagicaVoxel model sliced along z into an RGBA8 sheet, bottom slice first and seen from
+// above. Slices share one row when it fits in a texture, larger models fill a slice grid.
+struct VoxSheet {
+    Image image{};
+    SheetLayout layout;
+};
+
+bool IsVoxFile(const char *path);
+// Reads the first model of the file, then colours its voxels from the palette in parallel on
+// the pool. The image is left empty when the data is not a supported MagicaVoxel file.
+VoxSheet LoadVoxFromMemory(const unsigned char *data, int size, ThreadPool &pool);
@@ -0,0 +1,301 @@
+#include "voxel_volume.h"
+
+#include <algorithm>
+#include <cmath>
+
+struct Vec3 {
+    float x, y, z;
+};
+
+// First pixel of the cell of every slice of the frame
+static std::vector<const uint32_t *> GetLayerPixels(const Image &sheet, const SheetLayout &layout, int frame) {
+    Vector2 cellSize = GetLayoutCellSize(layout, sheet.width, sheet.height);
+    const uint32_t *pixels = static_cast<const uint32_t *>(sheet.data);
+
+    std::vector<const uint32_t *> layers;
+    for (int z = 0; z < layout.slices; z++) {
+        Rectangle cell = GetLayoutCell(layout, cellSize, z, frame);
+        layers.push_back(pixels + (size_t)cell.y * sheet.width + (size_t)cell.x);
+    }
+    return layers;
+}
+
+VoxelVolume BuildVoxelVolume(const Image &sheet, const SheetLayout &layout, int frame) {
+    VoxelVolume volume;
+    if (sheet.data == nullptr || sheet.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return volume;
+
+    Vector2 cellSize = GetLayoutCellSize(layout, sheet.width, sheet.height);
+    volume.sizeX = (int)cellSize.x;
+    volume.sizeY = (int)cellSize.y;
+    volume.sizeZ = layout.slices;
+    volume.voxels.resize((size_t)volume.sizeX * volume.sizeY * volume.sizeZ);
+
+    std::vector<const uint32_t *> layers = GetLayerPixels(sheet, layout, frame);
+    for (int z = 0; z < volume.sizeZ; z++) {
+        for (int y = 0; y < volume.sizeY; y++) {
+            const uint32_t *row = layers[z] + (size_t)y * sheet.width;
+            uint32_t *layer = volume.voxels.data() + ((size_t)z * volume.sizeY + y) * volume.sizeX;
+            std::copy(row, row + volume.sizeX, layer);
+        }
+    }
+
+    return volume;
+}
+
+static uint32_t ShadeVoxel(uint32_t color, int axis) {
+    // Top faces keep their color, side faces get darker to show the shape
+    const int shade[3] = {205, 230, 256};
+    uint32_t r = ((color & 0xFF) * shade[axis]) >> 8;
+    uint32_t g = (((color >> 8) & 0xFF) * shade[axis]) >> 8;
+    uint32_t b = (((color >> 16) & 0xFF) * shade[axis]) >> 8;
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+// Slab test against a box, gives the range of t inside it and the axis of the face the ray
+// enters through
+static bool EnterVolume(const float low[3], const float high[3], const float o[3], const float d[3], float &tEnter,
+                        float &tExit, int &enterAxis) {
+    tEnter = 0.0f;
+    tExit = INFINITY;
+    enterAxis = 2;
+    for (int a = 0; a < 3; a++) {
+        if (d[a] == 0.0f) {
+            if (o[a] < low[a] || o[a] >= high[a]) return false;
+            continue;
+        }
+        float t0 = (low[a] - o[a]) / d[a];
+        float t1 = (high[a] - o[a]) / d[a];
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > tEnter) {
+            tEnter = t0;
+            enterAxis = a;
+        }
+        tExit = std::min(tExit, t1);
+    }
+    return tExit > tEnter;
+}
+
+// Amanatides-Woo traversal from the point where the ray enters the volume
+static uint32_t MarchRay(const VoxelVolume &volume, Vec3 origin, Vec3 dir) {
+    const float zero[3] = {0.0f, 0.0f, 0.0f};
+    const float size[3] = {(float)volume.sizeX, (float)volume.sizeY, (float)volume.sizeZ};
+    const float o[3] = {origin.x, origin.y, origin.z};
+    const float d[3] = {dir.x, dir.y, dir.z};
+
+    float tEnter, tExit;
+    int enterAxis;
+    if (!EnterVolume(zero, size, o, d, tEnter, tExit, enterAxis)) return 0;
+
+    int cell[3], step[3];
+    float tMax[3], tDelta[3];
+    for (int a = 0; a < 3; a++) {
+        float p = o[a] + d[a] * (tEnter + 1e-4f);
+        cell[a] = std::min(std::max((int)floorf(p), 0), (int)size[a] - 1);
+        step[a] = d[a] > 0.0f ? 1 : -1;
+        tDelta[a] = d[a] != 0.0f ? fabsf(1.0f / d[a]) : INFINITY;
+        float boundary = (float)(cell[a] + (step[a] > 0 ? 1 : 0));
+        tMax[a] = d[a] != 0.0f ? (boundary - o[a]) / d[a] : INFINITY;
+    }
+
+    int axis = enterAxis;
+    while (true) {
+        uint32_t voxel = volume.voxels[((size_t)cell[2] * volume.sizeY + cell[1]) * volume.sizeX + cell[0]];
+        if (voxel >> 24) return ShadeVoxel(voxel, axis);
+
+        axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= (int)size[axis]) return 0;
+        tMax[axis] += tDelta[axis];
+    }
+}
+
+// Traversal over the (x, y) columns only, starting at the box around the solid voxels. Inside
+// a column the ray covers a range of layers that is checked against the column spans at once,
+// so empty space around the content, above, below and between spans costs nothing.
+static uint32_t MarchRayRunLength(const RunLengthVolume &volume, Vec3 origin, Vec3 dir) {
+    const float low[3] = {(float)volume.boundsMin[0], (float)volume.boundsMin[1], (float)volume.boundsMin[2]};
+    const float high[3] = {(float)volume.boundsMax[0], (float)volume.boundsMax[1], (float)volume.boundsMax[2]};
+    const float o[3] = {origin.x, origin.y, origin.z};
+    const float d[3] = {dir.x, dir.y, dir.z};
+
+    float tEnter, tExit;
+    int enterAxis;
+    if (!EnterVolume(low, high, o, d, tEnter, tExit, enterAxis)) return 0;
+
+    int cell[2], step[2];
+    float tMax[2], tDelta[2];
+    for (int a = 0; a < 2; a++) {
+        float p = o[a] + d[a] * (tEnter + 1e-4f);
+        cell[a] = std::min(std::max((int)floorf(p), (int)low[a]), (int)high[a] - 1);
+        step[a] = d[a] > 0.0f ? 1 : -1;
+        tDelta[a] = d[a] != 0.0f ? fabsf(1.0f / d[a]) : INFINITY;
+        float boundary = (float)(cell[a] + (step[a] > 0 ? 1 : 0));
+        tMax[a] = d[a] != 0.0f ? (boundary - o[a]) / d[a] : INFINITY;
+    }
+
+    const float epsilon = 1e-4f;
+    int sideAxis = enterAxis;
+    float t = tEnter;
+
+    while (true) {
+        float tNext = std::min({tMax[0], tMax[1], tExit});
+        float zIn = o[2] + d[2] * t;
+        float zOut = o[2] + d[2] * tNext;
+
+        // Layers in the order the ray crosses them
+        int first, last;
+        if (d[2] < 0.0f) {
+            first = (int)floorf(zIn - epsilon);
+            last = (int)floorf(zOut + epsilon);
+        } else {
+            first = (int)floorf(zIn + epsilon);
+            last = (int)floorf(zOut - epsilon);
+        }
+        first = std::min(std::max(first, volume.boundsMin[2]), volume.boundsMax[2] - 1);
+        last = std::min(std::max(last, volume.boundsMin[2]), volume.boundsMax[2] - 1);
+        int lowest = std::min(first, last);
+        int highest = std::max(first, last);
+
+        size_t column = (size_t)cell[1] * volume.sizeX + cell[0];
+        const VoxelSpan *begin = volume.spans.data() + volume.columns[column];
+        const VoxelSpan *end = volume.spans.data() + volume.columns[column + 1];
+
+        // Spans are sorted bottom up, the hit is the crossed layer nearest to the first one
+        int hit = -1;
+        const VoxelSpan *hitSpan = nullptr;
+        for (const VoxelSpan *span = begin; span != end; span++) {
+            int spanLow = std::max((int)span->start, lowest);
+            int spanHigh = std::min((int)span->start + span->length - 1, highest);
+            if (spanLow > spanHigh) continue;
+
+            int layer = d[2] < 0.0f ? spanHigh : spanLow;
+            if (hitSpan == nullptr || (d[2] < 0.0f ? layer > hit : layer < hit)) {
+                hit = layer;
+                hitSpan = span;
+            }
+        }
+
+        if (hitSpan != nullptr) {
+            uint32_t voxel = volume.colors[hitSpan->colorOffset + (hit - hitSpan->start)];
+            // Hitting the first crossed layer means the ray came in through the column side
+            return ShadeVoxel(voxel, hit == first ? sideAxis : 2);
+        }
+
+        if (tNext >= tExit) return 0;
+
+        int axis = tMax[0] < tMax[1] ? 0 : 1;
+        cell[axis] += step[axis];
+        if (cell[axis] < (int)low[axis] || cell[axis] >= (int)high[axis]) return 0;
+        t = tMax[axis];
+        tMax[axis] += tDelta[axis];
+        sideAxis = axis;
+    }
+}
+
+// Casts one orthographic ray per pixel of the target, centred on the volume
+template <typename March>
+static void CastRays(int sizeX, int sizeY, int sizeZ, const VoxelCamera &camera, Image &target, ThreadPool &pool,
+                     March march) {
+    uint32_t *pixels = static_cast<uint32_t *>(target.data);
+
+    // Camera looking from +y towards -y and down, then turned around z. Rotating the camera
+    // by -yaw shows the volume turned by yaw, clockwise on screen like DrawTexturePro.
+    float pitch = camera.pitch * DEG2RAD;
+    float yaw = -camera.yaw * DEG2RAD;
+    auto turn = [yaw](Vec3 v) {
+        return Vec3{v.x * cosf(yaw) - v.y * sinf(yaw), v.x * sinf(yaw) + v.y * cosf(yaw), v.z};
+    };
+    Vec3 right = turn(Vec3{1.0f, 0.0f, 0.0f});
+    Vec3 forward = turn(Vec3{0.0f, -cosf(pitch), -sinf(pitch)});
+    Vec3 up = turn(Vec3{0.0f, -sinf(pitch), cosf(pitch)});
+
+    Vec3 center = {sizeX / 2.0f, sizeY / 2.0f, sizeZ / 2.0f};
+    float distance = (float)(sizeX + sizeY + sizeZ);
+    float halfWidth = target.width / 2.0f;
+    float halfHeight = target.height / 2.0f;
+
+    ParallelFor(pool, target.height, [&](int begin, int end) {
+        for (int py = begin; py < end; py++) {
+            float v = (halfHeight - py - 0.5f) / camera.zoom;
+            for (int px = 0; px < target.width; px++) {
+                float u = (px + 0.5f - halfWidth) / camera.zoom;
+                Vec3 origin = {center.x + right.x * u + up.x * v - forward.x * distance,
+                               center.y + right.y * u + up.y * v - forward.y * distance,
+                               center.z + right.z * u + up.z * v - forward.z * distance};
+                pixels[(size_t)py * target.width + px] = march(origin, forward);
+            }
+        }
+    });
+}
+
+static bool ClearIfEmpty(bool empty, Image &target) {
+    if (target.data == nullptr || target.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return true;
+    if (empty) {
+        uint32_t *pixels = static_cast<uint32_t *>(target.data);
+        std::fill(pixels, pixels + (size_t)target.width * target.height, 0u);
+    }
+    return empty;
+}
+
+void RenderVoxelVolume(const VoxelVolume &volume, const VoxelCamera &camera, Image &target, ThreadPool &pool) {
+    if (ClearIfEmpty(volume.voxels.empty(), target)) return;
+
+    CastRays(volume.sizeX, volume.sizeY, volume.sizeZ, camera, target, pool,
+             [&volume](Vec3 origin, Vec3 dir) { return MarchRay(volume, origin, dir); });
+}
+
+RunLengthVolume BuildRunLengthVolume(const Image &sheet, const SheetLayout &layout, int frame) {
+    RunLengthVolume volume;
+    if (sheet.data == nullptr || sheet.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return volume;
+
+    Vector2 cellSize = GetLayoutCellSize(layout, sheet.width, sheet.height);
+    volume.sizeX = (int)cellSize.x;
+    volume.sizeY = (int)cellSize.y;
+    volume.sizeZ = layout.slices;
+    volume.columns.reserve((size_t)volume.sizeX * volume.sizeY + 1);
+    int *low = volume.boundsMin;
+    int *high = volume.boundsMax;
+    low[0] = volume.sizeX, low[1] = volume.sizeY, low[2] = volume.sizeZ;
+    high[0] = high[1] = high[2] = 0;
+
+    std::vector<const uint32_t *> layers = GetLayerPixels(sheet, layout, frame);
+    for (int y = 0; y < volume.sizeY; y++) {
+        size_t row = (size_t)y * sheet.width;
+        for (int x = 0; x < volume.sizeX; x++) {
+            volume.columns.push_back((uint32_t)volume.spans.size());
+
+            for (int z = 0; z < volume.sizeZ; z++) {
+                uint32_t voxel = layers[z][row + x];
+                if ((voxel >> 24) == 0) continue;
+
+                bool extends = !volume.spans.empty() && volume.columns.back() < volume.spans.size() &&
+                               volume.spans.back().start + volume.spans.back().length == z;
+                if (extends)
+                    volume.spans.back().length++;
+                else
+                    volume.spans.push_back(VoxelSpan{(uint16_t)z, 1, (uint32_t)volume.colors.size()});
+                volume.colors.push_back(voxel);
+
+                low[0] = std::min(low[0], x), high[0] = std::max(high[0], x + 1);
+                low[1] = std::min(low[1], y), high[1] = std::max(high[1], y + 1);
+                low[2] = std::min(low[2], z), high[2] = std::max(high[2], z + 1);
+            }
+        }
+    }
+    volume.columns.push_back((uint32_t)volume.spans.size());
+
+    return volume;
+}
+
+size_t GetRunLengthVolumeSize(const RunLengthVolume &volume) {
+    return volume.columns.size() * sizeof(uint32_t) + volume.spans.size() * sizeof(VoxelSpan) +
+           volume.colors.size() * sizeof(uint32_t);
+}
+
+void RenderRunLengthVolume(const RunLengthVolume &volume, const VoxelCamera &camera, Image &target,
+                           ThreadPool &pool) {
+    if (ClearIfEmpty(volume.spans.empty(), target)) return;
+
+    CastRays(volume.sizeX, volume.sizeY, volume.sizeZ, camera, target, pool,
+             [&volume](Vec3 origin, Vec3 dir) { return MarchRayRunLength(volume, origin, dir); });
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+#include "sheet_layout.h"
+#include "thread_pool.h"
+
+// Dense grid of RGBA8 voxels, x and y come from a slice, z is the slice index going up.
+// A voxel with zero alpha is empty.
+struct VoxelVolume {
+    int sizeX{0};
+    int sizeY{0};
+    int sizeZ{0};
+    std::vector<uint32_t> voxels;
+};
+
+// Solid voxels of a column along z, colors of consecutive layers are stored together
+struct VoxelSpan {
+    uint16_t start;
+    uint16_t length;
+    uint32_t colorOffset;
+};
+
+// Same content as VoxelVolume with only the solid voxels stored: every (x, y) column keeps
+// its spans, sorted bottom up. Stacks are mostly empty space so this is much smaller, and the
+// renderer skips the empty layers of a column in one go.
+struct RunLengthVolume {
+    int sizeX{0};
+    int sizeY{0};
+    int sizeZ{0};
+    // Box around the solid voxels, the max corner is exclusive
+    int boundsMin[3]{0, 0, 0};
+    int boundsMax[3]{0, 0, 0};
+    // First span of every column, plus one past the last span
+    std::vector<uint32_t> columns;
+    std::vector<VoxelSpan> spans;
+    std::vector<uint32_t> colors;
+};
+
+// Orthographic view, yaw turns around the vertical axis like the stack rotation and pitch
+// goes from 0 (side view) to 90 (top view). Zoom is in screen pixels per voxel.
+struct VoxelCamera {
+    float yaw{0.0f};
+    float pitch{45.0f};
+    float zoom{8.0f};
+};
+
+// Every slice of one animation frame of a RGBA8 sheet becomes a layer of the volume
+VoxelVolume BuildVoxelVolume(const Image &sheet, const SheetLayout &layout, int frame);
+// Ray-marches the volume into a RGBA8 image centred on the volume, pixels that miss it are
+// left transparent. The cost depends on the image size, not on the slice count.
+void RenderVoxelVolume(const VoxelVolume &volume, const VoxelCamera &camera, Image &target, ThreadPool &pool);
+
+RunLengthVolume BuildRunLengthVolume(const Image &sheet, const SheetLayout &layout, int frame);
+// Bytes used by the columns, spans and colors
+size_t GetRunLengthVolumeSize(const RunLengthVolume &volume);
+void RenderRunLengthVolume(const RunLengthVolume &volume, const VoxelCamera &camera, Image &target,
+                           ThreadPool &pool);
@@ -0,0 +1,72 @@
+// Rasterizes the UI font at build time into a header holding the glyph metrics and a binary
+// holding the atlas, which CMake embeds, so the application starts with a single texture
+// upload instead of parsing the TTF.
+// Usage: FontBaker <font.ttf> <size> <metrics.h> <atlas.bin>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "raylib.h"
+
+// Printable ASCII, everything the UI draws
+const int GLYPH_COUNT = 95;
+// Same padding raylib gives TTF fonts loaded at runtime
+const int GLYPH_PADDING = 4;
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        std::cerr << "Usage: FontBaker <font.ttf> <size> <metrics.h> <atlas.bin>" << std::endl;
+        return 1;
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    int fontSize = std::stoi(argv[2]);
+    int dataSize = 0;
+    unsigned char *data = LoadFileData(argv[1], &dataSize);
+    if (data == nullptr) return 1;
+
+    GlyphInfo *glyphs = LoadFontData(data, dataSize, fontSize, nullptr, GLYPH_COUNT, FONT_DEFAULT);
+    UnloadFileData(data);
+    if (glyphs == nullptr) return 1;
+
+    Rectangle *recs = nullptr;
+    Image atlas = GenImageFontAtlas(glyphs, &recs, GLYPH_COUNT, fontSize, GLYPH_PADDING, 0);
+
+    // The atlas is white, only the alpha channel is stored
+    std::vector<unsigned char> alpha((size_t)atlas.width * atlas.height);
+    const unsigned char *grayAlpha = static_cast<const unsigned char *>(atlas.data);
+    for (size_t i = 0; i < alpha.size(); i++) alpha[i] = grayAlpha[2 * i + 1];
+
+    int compressedSize = 0;
+    unsigned char *compressed = CompressData(alpha.data(), (int)alpha.size(), &compressedSize);
+    if (compressed == nullptr) return 1;
+    // The alpha of the atlas, DEFLATE compressed
+    bool saved = SaveFileData(argv[4], compressed, compressedSize);
+
+    std::ofstream file(argv[3], std::ios::trunc);
+    file << "// Generated by FontBaker from " << GetFileName(argv[1]) << ", do not edit\n\n";
+    file << "const int UI_FONT_SIZE = " << fontSize << ";\n";
+    file << "const int UI_FONT_PADDING = " << GLYPH_PADDING << ";\n";
+    file << "const int UI_FONT_ATLAS_WIDTH = " << atlas.width << ";\n";
+    file << "const int UI_FONT_ATLAS_HEIGHT = " << atlas.height << ";\n\n";
+
+    file << "// Codepoint, offset x and y, advance, then the rectangle on the atlas\n";
+    file << "const int UI_FONT_GLYPHS[" << GLYPH_COUNT << "][8] = {\n";
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        const GlyphInfo &glyph = glyphs[i];
+        const Rectangle &rec = recs[i];
+        file << "    {" << glyph.value << ", " << glyph.offsetX << ", " << glyph.offsetY << ", " << glyph.advanceX
+             << ", " << (int)rec.x << ", " << (int)rec.y << ", " << (int)rec.width << ", " << (int)rec.height
+             << "},\n";
+    }
+    file << "};\n";
+
+    MemFree(compressed);
+    MemFree(recs);
+    UnloadImage(atlas);
+    UnloadFontData(glyphs, GLYPH_COUNT);
+
+    return file && saved ? 0 : 1;
+}